@@ -0,0 +1,117 @@
+#include "BitVector.h"
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Returns the position of the r-th set bit (counting from 1) of a word that has at least r of them.
+static size_t selectInWord(uint64_t word, size_t r)
+{
+#if defined(__BMI2__)
+    return size_t(__builtin_ctzll(_pdep_u64(uint64_t(1) << (r - 1), word)));
+#else
+    size_t shift = 0;
+    for (;; shift += 8) // Skip whole bytes first
+    {
+        size_t count = size_t(__builtin_popcountll((word >> shift) & 0xff));
+        if (r <= count)
+            break;
+        r -= count;
+    }
+    uint64_t bits = word >> shift;
+    for (size_t i = 1; i < r; i++)
+        bits &= bits - 1; // Drop the lowest set bits until the wanted one is the lowest
+    return shift + size_t(__builtin_ctzll(bits));
+#endif
+}
+
+// Appends a bit, opening a new word every 64 bits.
+void BitVector::push(bool bit)
+{
+    if (bits % 64 == 0)
+        words.push_back(0);
+    if (bit)
+        words.back() |= uint64_t(1) << (bits % 64);
+    bits++;
+}
+
+// Counts the 1s before every block and samples the block of every SELECT_SAMPLE-th 0.
+void BitVector::buildIndex()
+{
+    size_t blocks = (words.size() + BLOCK_WORDS - 1) / BLOCK_WORDS;
+    blockOnes.assign(blocks + 1, 0);
+    for (size_t b = 0; b < blocks; b++)
+    {
+        uint32_t ones = 0;
+        for (size_t w = b * BLOCK_WORDS; w < words.size() && w < (b + 1) * BLOCK_WORDS; w++)
+            ones += uint32_t(__builtin_popcountll(words[w]));
+        blockOnes[b + 1] = blockOnes[b] + ones;
+    }
+
+    zeroSamples.clear();
+    size_t totalZeros = bits - blockOnes[blocks];
+    for (size_t b = 0; b < blocks; b++)
+    {
+        size_t zerosEnd = b + 1 < blocks ? zerosBefore(b + 1) : totalZeros;
+        while (zeroSamples.size() * SELECT_SAMPLE < zerosEnd)
+            zeroSamples.push_back(uint32_t(b));
+    }
+}
+
+// Adds the block count to the 1s in the whole words and the partial word before i.
+size_t BitVector::rank1(size_t i) const
+{
+    size_t word = i / 64;
+    size_t rank = blockOnes[word / BLOCK_WORDS];
+    for (size_t w = word - word % BLOCK_WORDS; w < word; w++)
+        rank += __builtin_popcountll(words[w]);
+    if (i % 64 != 0)
+        rank += __builtin_popcountll(words[word] & ((uint64_t(1) << (i % 64)) - 1));
+    return rank;
+}
+
+// Narrows the block with the sampled positions, binary searches the block counts, then scans words.
+size_t BitVector::select0(size_t k) const
+{
+    size_t sample = (k - 1) / SELECT_SAMPLE;
+    size_t lo = zeroSamples[sample];
+    size_t hi = sample + 1 < zeroSamples.size() ? zeroSamples[sample + 1] + 1 : blockOnes.size() - 1;
+    while (hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (zerosBefore(mid) < k)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    size_t remaining = k - zerosBefore(lo);
+    for (size_t w = lo * BLOCK_WORDS;; w++)
+    {
+        uint64_t zeros = ~words[w];
+        size_t count = size_t(__builtin_popcountll(zeros));
+        if (remaining <= count)
+            return w * 64 + selectInWord(zeros, remaining);
+        remaining -= count;
+    }
+}
+
+// Scans forward a word at a time for the next 0.
+size_t BitVector::nextZero(size_t i) const
+{
+    if (i >= bits)
+        return bits;
+    size_t w = i / 64;
+    uint64_t zeros = ~words[w] >> (i % 64);
+    size_t pos = bits;
+    if (zeros != 0)
+        pos = i + size_t(__builtin_ctzll(zeros));
+    else
+    {
+        for (w++; w < words.size() && pos == bits; w++)
+        {
+            if (~words[w] != 0)
+                pos = w * 64 + size_t(__builtin_ctzll(~words[w]));
+        }
+    }
+    return pos < bits ? pos : bits; // Unused bits of the last word read as 0s
+}
@@ -0,0 +1,46 @@
+#ifndef BIT_VECTOR_H
+#define BIT_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Append-only bit string with constant-time rank and fast select, used by the frozen trie.
+// Bits are pushed one at a time; buildIndex() then adds a count of 1s per 512-bit block (6% on
+// top of the bits) and the block of every 256th 0, which bounds the search done by select0().
+class BitVector
+{
+public:
+    // Appends a bit. Invalidates the index until the next buildIndex().
+    void push(bool bit);
+
+    // Builds the rank/select index. Must be called after the last push().
+    void buildIndex();
+
+    bool get(size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+
+    // Returns the number of 1s in positions [0, i).
+    size_t rank1(size_t i) const;
+
+    // Returns the position of the k-th 0 (counting from 1). There must be at least k 0s.
+    size_t select0(size_t k) const;
+
+    // Returns the position of the first 0 at or after i, or size() if there is none.
+    size_t nextZero(size_t i) const;
+
+    size_t size() const { return bits; }
+    size_t bytesUsed() const { return words.size() * sizeof(uint64_t) + (blockOnes.size() + zeroSamples.size()) * sizeof(uint32_t); }
+
+private:
+    static constexpr size_t BLOCK_WORDS = 8;     // 512-bit blocks
+    static constexpr size_t SELECT_SAMPLE = 256; // Every 256th 0 has its block recorded
+
+    size_t zerosBefore(size_t block) const { return block * BLOCK_WORDS * 64 - blockOnes[block]; }
+
+    std::vector<uint64_t> words;
+    std::vector<uint32_t> blockOnes;   // 1s before each block; one extra entry for the end
+    std::vector<uint32_t> zeroSamples; // zeroSamples[j] is the block holding the (j * SELECT_SAMPLE + 1)-th 0
+    size_t bits = 0;
+};
+
+#endif // BIT_VECTOR_H
@@ -0,0 +1,177 @@
+#include "DefinitionIndex.h"
+#include "DictionaryParser.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cctype>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Calls visit(term) for every run of two or more letters in the text, lowercased into `term`.
+template <typename Visit>
+static void forEachTerm(std::string_view text, std::string &term, Visit visit)
+{
+    term.clear();
+    for (size_t i = 0; i <= text.size(); i++)
+    {
+        int ch = i < text.size() ? tolower(static_cast<unsigned char>(text[i])) : 0;
+        if (ch >= 'a' && ch <= 'z')
+        {
+            term.push_back(char(ch));
+            continue;
+        }
+        if (term.size() >= 2)
+            visit(term);
+        term.clear();
+    }
+}
+
+// Writes the gap from the previous id, 7 bits per byte with the high bit set on all but the last.
+void DefinitionIndex::append(PostingList &list, uint32_t id)
+{
+    uint32_t gap = id - list.last;
+    while (gap >= 0x80)
+    {
+        list.bytes.push_back(uint8_t(gap | 0x80));
+        gap >>= 7;
+    }
+    list.bytes.push_back(uint8_t(gap));
+    list.last = id;
+    list.count++;
+}
+
+void DefinitionIndex::decode(const PostingList &list, std::vector<uint32_t> &ids)
+{
+    ids.clear();
+    ids.reserve(list.count);
+    uint32_t id = 0;
+    for (size_t i = 0; i < list.bytes.size();)
+    {
+        uint32_t gap = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            uint8_t byte = list.bytes[i++];
+            gap |= uint32_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        id += gap;
+        ids.push_back(id);
+    }
+}
+
+// A word's terms are appended in text order; a term already given this id is not appended twice.
+void DefinitionIndex::add(std::string_view word, std::string_view meaning)
+{
+    std::string key = wordKey(word);
+    remove(key);
+    uint32_t id = uint32_t(words.size());
+    words.push_back(key);
+    live.push_back(true);
+    ids[key] = id;
+
+    DictionaryRecord record;
+    splitMeaning(meaning, record);
+    std::string term;
+    forEachTerm(record.definition, term, [&](const std::string &found) {
+        PostingList &list = postings[found];
+        if (list.count > 0 && list.last == id)
+            return;
+        size_t before = list.bytes.size();
+        append(list, id);
+        encodedBytes += list.bytes.size() - before;
+    });
+}
+
+bool DefinitionIndex::remove(std::string_view word)
+{
+    auto found = ids.find(wordKey(word));
+    if (found == ids.end())
+        return false;
+    live[found->second] = false;
+    ids.erase(found);
+    return true;
+}
+
+// Keeps the ids of `result` that also occur in `other`; both are sorted. For each id, blocks of
+// four ids of `other` that end below it are skipped, then the id is compared with the next four
+// at once. `result` is the shorter list, so most of `other` is passed over four ids at a time.
+// Without SSE2, `other` is walked one id at a time.
+static void intersect(std::vector<uint32_t> &result, const std::vector<uint32_t> &other)
+{
+    size_t kept = 0, j = 0, size = other.size();
+    for (uint32_t id : result)
+    {
+#if defined(__SSE2__)
+        while (j + 4 <= size && other[j + 3] < id)
+            j += 4;
+        if (j + 4 <= size)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(other.data() + j));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(block, _mm_set1_epi32(int(id)))) != 0)
+                result[kept++] = id;
+            continue;
+        }
+#endif
+        while (j < size && other[j] < id)
+            j++;
+        if (j < size && other[j] == id)
+            result[kept++] = id;
+    }
+    result.resize(kept);
+}
+
+// Decodes the shortest posting list first and intersects it with the others in order of length,
+// so the candidate list only shrinks.
+std::vector<std::string> DefinitionIndex::search(std::string_view query, size_t limit) const
+{
+    METRICS_SCOPE(METRIC_DEFINITION_SEARCH);
+    std::vector<const PostingList *> lists;
+    std::string term;
+    bool missing = false;
+    forEachTerm(query, term, [&](const std::string &found) {
+        auto list = postings.find(found);
+        if (list == postings.end())
+            missing = true;
+        else if (std::find(lists.begin(), lists.end(), &list->second) == lists.end())
+            lists.push_back(&list->second);
+    });
+    if (missing || lists.empty() || limit == 0)
+        return {};
+    std::sort(lists.begin(), lists.end(), [](const PostingList *a, const PostingList *b) { return a->count < b->count; });
+
+    std::vector<uint32_t> result, other;
+    decode(*lists[0], result);
+    for (size_t i = 1; i < lists.size() && !result.empty(); i++)
+    {
+        decode(*lists[i], other);
+        intersect(result, other);
+    }
+
+    std::vector<std::string> matches;
+    for (size_t i = 0; i < result.size() && matches.size() < limit; i++)
+    {
+        if (live[result[i]])
+            matches.push_back(words[result[i]]);
+    }
+    return matches;
+}
+
+// Depth-first walk that indexes each word's meaning as it is reached. Compressed meanings are
+// decoded into `buffer`.
+static void indexNode(DefinitionIndex &index, const Trie *trie, const TrieNode *node, std::string &word, std::string &buffer)
+{
+    if (node->isEndOfWord)
+        index.add(word, readMeaning(trie, node, buffer));
+    forEachChild(trie, node, [&](int i, TrieNode *child) {
+        word.push_back(char('a' + i));
+        indexNode(index, trie, child, word, buffer);
+        word.pop_back();
+    });
+}
+
+void indexDefinitions(DefinitionIndex &index, const Trie *trie)
+{
+    std::string word, buffer;
+    indexNode(index, trie, nodeAt(trie, trie->root), word, buffer);
+}
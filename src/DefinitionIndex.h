@@ -0,0 +1,56 @@
+#ifndef DEFINITION_INDEX_H
+#define DEFINITION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Trie.h"
+
+// Inverted index from the terms of each word's definition back to the word, for reverse lookup.
+// A term is a run of two or more letters, lowercased. Every indexed word gets the next id, and
+// each term keeps the ids of the words using it as a sorted posting list, stored as the gaps
+// between ids in variable-length bytes (7 bits per byte). Ids only grow, so adding a word
+// appends to the end of its terms' lists. A word that is indexed again gets a new id and its old
+// one is marked dead; dead ids stay in the lists and are skipped when a query runs.
+class DefinitionIndex
+{
+public:
+    // Indexes the definition part of a meaning line ("partOfSpeech|definition"), replacing the
+    // word's previous definition. The word is stored by its letters, lowercased, as in the Trie.
+    void add(std::string_view word, std::string_view meaning);
+
+    // Drops the word from query results. Returns true if it was indexed.
+    bool remove(std::string_view word);
+
+    // Returns up to `limit` words whose definitions contain every term of the query, in the
+    // order they were indexed. A query without terms matches nothing.
+    std::vector<std::string> search(std::string_view query, size_t limit) const;
+
+    size_t wordCount() const { return ids.size(); } // Live words
+    size_t termCount() const { return postings.size(); }
+    size_t postingBytes() const { return encodedBytes; }
+
+private:
+    struct PostingList {
+        std::vector<uint8_t> bytes; // Gap from the previous id (or from 0), 7 bits per byte
+        uint32_t count = 0;
+        uint32_t last = 0; // Last id appended
+    };
+
+    static void append(PostingList &list, uint32_t id);
+    static void decode(const PostingList &list, std::vector<uint32_t> &ids);
+
+    std::unordered_map<std::string, PostingList> postings;
+    std::vector<std::string> words; // Word of each id, dead ones included
+    std::vector<bool> live;
+    std::unordered_map<std::string, uint32_t> ids; // Current id of each live word
+    size_t encodedBytes = 0;
+};
+
+// Indexes every word of the trie with its meaning, in alphabetical order.
+void indexDefinitions(DefinitionIndex &index, const Trie *trie);
+
+#endif // DEFINITION_INDEX_H
@@ -0,0 +1,324 @@
+#include "DictionaryImage.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <sys/stat.h>
+
+// Fixed-size header at the start of an image. It is followed by the arena's free-list heads
+// (uint32 each) and the filled length of every meaning chunk (uint64 each). The node slabs start
+// at the next page boundary, SLAB_SIZE bytes each, and the meaning chunks follow them, each padded
+// to 8 bytes.
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slabBits;  // NodeArena::SLAB_BITS of the build that wrote the image
+    uint32_t chunkBits; // MeaningPool::CHUNK_BITS of the build that wrote the image
+    uint32_t root;
+    uint64_t fileSize;
+    uint64_t checksum;       // Of the whole image, computed with both checksums set to 0
+    uint64_t tablesChecksum; // Of the header and its tables only, computed the same way
+    uint64_t wordsSize, wordsModified;
+    uint64_t meaningsSize, meaningsModified;
+    uint64_t nodeCount;
+    uint64_t slabCount, lastSlabUsed, nodeBytesUsed, freeListCount;
+    uint64_t chunkCount;
+};
+
+static const char IMAGE_MAGIC[8] = {'G', 'D', 'I', 'C', 'T', 'I', 'M', 'G'};
+static const size_t PAGE_SIZE = 4096;
+
+static size_t roundUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// Hashes the image eight bytes at a time in four independent lanes, so it runs at close to memory speed.
+static uint64_t checksum(const char *data, size_t size)
+{
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    uint64_t lanes[4] = {1, 2, 3, 4};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i + lane * 8, 8);
+            uint64_t mixed = (lanes[lane] ^ word) * PRIME;
+            lanes[lane] = (mixed << 29) | (mixed >> 35);
+        }
+    }
+    uint64_t hash = size;
+    for (uint64_t lane : lanes)
+        hash = (hash ^ lane) * PRIME;
+    for (; i < size; i++)
+        hash = (hash ^ uint8_t(data[i])) * PRIME;
+    return hash ^ (hash >> 32);
+}
+
+// Reads the size and modification time of a file, the time in nanoseconds so that a file rewritten
+// within the same second as the image still makes it stale. Returns false if it does not exist.
+static bool fileStamp(const std::string &path, uint64_t &size, uint64_t &modified)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    size = uint64_t(info.st_size);
+    modified = uint64_t(info.st_mtim.tv_sec) * 1000000000u + uint64_t(info.st_mtim.tv_nsec);
+    return true;
+}
+
+// Identifies one state of an image file, for the record that its full checksum has been verified.
+// Writing to the file gives it a new change time, which unlike the modification time cannot be set
+// back, and replacing it gives it a new inode.
+struct VerifiedStamp {
+    uint64_t device, inode, size, changed;
+    uint64_t checksum; // The image's own checksum, from its header
+};
+
+static std::string verifiedPath(const std::string &imagePath)
+{
+    return imagePath + ".verified";
+}
+
+// Reads the current state of the image file. Returns false if it does not exist.
+static bool imageStamp(const std::string &imagePath, uint64_t checksum, VerifiedStamp &stamp)
+{
+    struct stat info;
+    if (stat(imagePath.c_str(), &info) != 0)
+        return false;
+    stamp.device = uint64_t(info.st_dev);
+    stamp.inode = uint64_t(info.st_ino);
+    stamp.size = uint64_t(info.st_size);
+    stamp.changed = uint64_t(info.st_ctim.tv_sec) * 1000000000u + uint64_t(info.st_ctim.tv_nsec);
+    stamp.checksum = checksum;
+    return true;
+}
+
+// Records that the image, as it is now, has passed the full checksum. A failed write only means
+// the next open verifies it again.
+static void recordVerified(const std::string &imagePath, const VerifiedStamp &stamp)
+{
+    std::ofstream file(verifiedPath(imagePath), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&stamp), sizeof(stamp));
+}
+
+// Returns true if the image in its current state has passed the full checksum, by the record or
+// by hashing it now (and recording that). Only the first open after the image is written or
+// changed reads every page.
+static bool verifiedOnce(const std::string &imagePath, uint64_t checksum)
+{
+    VerifiedStamp current, recorded;
+    if (!imageStamp(imagePath, checksum, current))
+        return false;
+    std::ifstream file(verifiedPath(imagePath), std::ios::binary);
+    if (file.read(reinterpret_cast<char *>(&recorded), sizeof(recorded)) && recorded.device == current.device &&
+        recorded.inode == current.inode && recorded.size == current.size && recorded.changed == current.changed &&
+        recorded.checksum == current.checksum)
+        return true;
+    if (!verifyDictionaryImage(imagePath))
+        return false;
+    recordVerified(imagePath, current); // Stamped before hashing, so a change made meanwhile is not covered
+    return true;
+}
+
+// Returns where the node slabs start: the first page boundary after the header and its tables.
+static size_t slabsStart(const ImageHeader &header)
+{
+    return roundUp(sizeof(ImageHeader) + header.freeListCount * sizeof(NodeRef) + header.chunkCount * sizeof(uint64_t), PAGE_SIZE);
+}
+
+// Lays the image out in memory, computes its checksums, then writes it next to the target and renames it.
+bool writeDictionaryImage(const Trie *trie, const std::string &imagePath, const std::string &wordFilename, const std::string &meaningFilename)
+{
+    if (trie->codec.trained())
+        return false;
+    ImageHeader header = {};
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    header.version = DICTIONARY_IMAGE_VERSION;
+    header.slabBits = NodeArena::SLAB_BITS;
+    header.chunkBits = MeaningPool::CHUNK_BITS;
+    header.root = trie->root;
+    if (!fileStamp(wordFilename, header.wordsSize, header.wordsModified) ||
+        !fileStamp(meaningFilename, header.meaningsSize, header.meaningsModified))
+        return false;
+
+    const std::vector<char *> &slabs = trie->nodes.slabList();
+    const std::vector<NodeRef> &freeLists = trie->nodes.freeListHeads();
+    const std::vector<char *> &chunks = trie->meanings.chunkList();
+    const std::vector<size_t> &chunkLengths = trie->meanings.chunkLengthList();
+    header.nodeCount = trie->nodeCount;
+    header.slabCount = slabs.size();
+    header.lastSlabUsed = trie->nodes.lastSlabUsed();
+    header.nodeBytesUsed = trie->nodes.bytesUsed();
+    header.freeListCount = freeLists.size();
+    header.chunkCount = chunks.size();
+
+    size_t size = slabsStart(header) + slabs.size() * NodeArena::SLAB_SIZE;
+    for (size_t length : chunkLengths)
+        size += roundUp(length, 8);
+    header.fileSize = size;
+
+    std::vector<char> image(size, 0);
+    char *tables = image.data() + sizeof(ImageHeader);
+    std::memcpy(tables, freeLists.data(), freeLists.size() * sizeof(NodeRef));
+    tables += freeLists.size() * sizeof(NodeRef);
+    for (size_t length : chunkLengths)
+    {
+        uint64_t length64 = length;
+        std::memcpy(tables, &length64, sizeof(length64));
+        tables += sizeof(length64);
+    }
+
+    char *out = image.data() + slabsStart(header);
+    for (size_t i = 0; i < slabs.size(); i++)
+    {
+        // Only the carved part of the last slab holds nodes; the rest stays zero.
+        size_t carved = i + 1 == slabs.size() ? header.lastSlabUsed : NodeArena::SLAB_SIZE;
+        std::memcpy(out, slabs[i], carved);
+        out += NodeArena::SLAB_SIZE;
+    }
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        std::memcpy(out, chunks[i], chunkLengths[i]);
+        out += roundUp(chunkLengths[i], 8);
+    }
+
+    std::memcpy(image.data(), &header, sizeof(header));
+    header.tablesChecksum = checksum(image.data(), slabsStart(header));
+    header.checksum = checksum(image.data(), image.size());
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    std::string tempPath = imagePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    file.write(image.data(), std::streamsize(image.size()));
+    file.close();
+    if (!file)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    if (std::rename(tempPath.c_str(), imagePath.c_str()) != 0)
+        return false;
+
+    // The checksum was just computed from the same bytes, so the image need not be hashed on open.
+    VerifiedStamp stamp;
+    if (imageStamp(imagePath, header.checksum, stamp))
+        recordVerified(imagePath, stamp);
+    return true;
+}
+
+// Checks the header, its tables and the file stamps. Only the header and its tables are hashed, so
+// the check takes the same time for any dictionary size and reads none of the slabs and chunks;
+// those are covered by the full checksum, which verifiedOnce() checks.
+static bool validImage(const MappedFile &image, size_t freeListCount, const std::string &wordFilename, const std::string &meaningFilename)
+{
+    if (image.size() < sizeof(ImageHeader))
+        return false;
+    ImageHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0 || header.version != DICTIONARY_IMAGE_VERSION ||
+        header.slabBits != NodeArena::SLAB_BITS || header.chunkBits != MeaningPool::CHUNK_BITS ||
+        header.fileSize != image.size() || header.freeListCount != freeListCount ||
+        header.slabCount == 0 || header.slabCount > NodeArena::MAX_SLABS || header.lastSlabUsed > NodeArena::SLAB_SIZE)
+        return false;
+
+    // A changed word or meaning file makes the image stale.
+    uint64_t size, modified;
+    if (!fileStamp(wordFilename, size, modified) || size != header.wordsSize || modified != header.wordsModified ||
+        !fileStamp(meaningFilename, size, modified) || size != header.meaningsSize || modified != header.meaningsModified)
+        return false;
+
+    // The tables and data must fit in the file before anything is read from them.
+    if (header.chunkCount > (image.size() - sizeof(ImageHeader)) / sizeof(uint64_t))
+        return false;
+    size_t expected = slabsStart(header) + header.slabCount * NodeArena::SLAB_SIZE;
+    if (expected > image.size())
+        return false;
+
+    // The header and tables are hashed from a copy, with the checksums zeroed as when they were written.
+    std::vector<char> tables(image.data(), image.data() + slabsStart(header));
+    ImageHeader zeroed = header;
+    zeroed.checksum = 0;
+    zeroed.tablesChecksum = 0;
+    std::memcpy(tables.data(), &zeroed, sizeof(zeroed));
+    if (checksum(tables.data(), tables.size()) != header.tablesChecksum)
+        return false;
+
+    const char *lengths = image.data() + sizeof(ImageHeader) + header.freeListCount * sizeof(NodeRef);
+    for (size_t i = 0; i < header.chunkCount; i++)
+    {
+        uint64_t length;
+        std::memcpy(&length, lengths + i * sizeof(length), sizeof(length));
+        if (length > MeaningPool::CHUNK_SIZE)
+            return false;
+        expected += roundUp(length, 8);
+    }
+    return expected == image.size();
+}
+
+bool verifyDictionaryImage(const std::string &imagePath)
+{
+    MappedFile image;
+    if (!image.open(imagePath) || image.size() < sizeof(ImageHeader))
+        return false;
+
+    // The mapping is private, so the checksum fields can be zeroed in place while hashing.
+    ImageHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    ImageHeader zeroed = header;
+    zeroed.checksum = 0;
+    zeroed.tablesChecksum = 0;
+    std::memcpy(image.data(), &zeroed, sizeof(zeroed));
+    return checksum(image.data(), image.size()) == header.checksum;
+}
+
+// Maps the image and hands its slabs and chunks to a new trie's arena and meaning pool. The slabs
+// hold node handles and meaning offsets that are used without bounds checks, so the full checksum
+// must have passed before they are adopted.
+Trie *openDictionaryImage(const std::string &imagePath, const std::string &wordFilename, const std::string &meaningFilename)
+{
+    Trie *trie = new Trie;
+    if (!trie->image.open(imagePath) || !validImage(trie->image, trie->nodes.freeListHeads().size(), wordFilename, meaningFilename))
+    {
+        delete trie;
+        return nullptr;
+    }
+
+    ImageHeader header;
+    std::memcpy(&header, trie->image.data(), sizeof(header));
+    if (!verifiedOnce(imagePath, header.checksum))
+    {
+        delete trie;
+        return nullptr;
+    }
+    const char *tables = trie->image.data() + sizeof(ImageHeader);
+    std::vector<NodeRef> freeLists(header.freeListCount);
+    std::memcpy(freeLists.data(), tables, freeLists.size() * sizeof(NodeRef));
+    tables += freeLists.size() * sizeof(NodeRef);
+
+    char *data = trie->image.data() + slabsStart(header);
+    std::vector<char *> slabs;
+    for (size_t i = 0; i < header.slabCount; i++)
+    {
+        slabs.push_back(data);
+        data += NodeArena::SLAB_SIZE;
+    }
+    std::vector<char *> chunks;
+    std::vector<size_t> chunkLengths;
+    for (size_t i = 0; i < header.chunkCount; i++)
+    {
+        uint64_t length;
+        std::memcpy(&length, tables + i * sizeof(length), sizeof(length));
+        chunks.push_back(data);
+        chunkLengths.push_back(size_t(length));
+        data += roundUp(size_t(length), 8);
+    }
+
+    trie->nodes.adopt(slabs, size_t(header.lastSlabUsed), size_t(header.nodeBytesUsed), freeLists);
+    trie->meanings.adopt(chunks, chunkLengths);
+    trie->root = header.root;
+    trie->nodeCount = size_t(header.nodeCount);
+    return trie;
+}
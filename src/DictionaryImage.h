@@ -0,0 +1,32 @@
+#ifndef DICTIONARY_IMAGE_H
+#define DICTIONARY_IMAGE_H
+
+#include <cstdint>
+#include <string>
+#include "Trie.h"
+
+// A dictionary image is a trie saved as its raw node slabs and meaning chunks, behind a header
+// holding the format version, checksums, and the size and modification time of the word and
+// meaning files it was built from. Node handles and meaning offsets do not depend on addresses,
+// so an opened image is used in place: the slabs and chunks are adopted straight from the mapping,
+// with no parsing and no per-node allocation.
+const uint32_t DICTIONARY_IMAGE_VERSION = 5; // 2: no '\r' at the end of meanings; 3: part of speech masks in nodes; 4: tables checksum; 5: times in ns
+
+// Writes the trie as an image stamped with the current state of the two text files, and records it
+// as verified. The image is written to a temporary file and renamed, so readers never see a partial
+// one. Returns false on failure, and for a trie whose meanings are compressed, which the image has
+// no place for.
+bool writeDictionaryImage(const Trie *trie, const std::string &imagePath, const std::string &wordFilename, const std::string &meaningFilename);
+
+// Maps an image and returns a trie that uses it in place. Returns nullptr if the image is missing,
+// has another version, fails its checksums, or was built from text files that have changed since.
+// The full checksum is only computed once per state of the image file: the result is recorded in
+// "<imagePath>.verified" (also by writeDictionaryImage()), keyed on the file's inode and change
+// time, so later opens read neither the slabs nor the chunks and take the same time for any
+// dictionary size. Changes made to the returned trie stay in memory and never reach the image.
+Trie *openDictionaryImage(const std::string &imagePath, const std::string &wordFilename, const std::string &meaningFilename);
+
+// Hashes the whole image and compares it with the checksum it was written with. Reads every page.
+bool verifyDictionaryImage(const std::string &imagePath);
+
+#endif // DICTIONARY_IMAGE_H
@@ -0,0 +1,199 @@
+#include "DictionaryLoader.h"
+#include "DictionaryParser.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Streams the two files through the parser and inserts every record straight from its read buffer.
+bool loadTextDictionary(Trie *trie, const std::string &wordFilename, const std::string &meaningFilename)
+{
+    DictionaryParser parser(wordFilename, meaningFilename);
+    if (!parser.isOpen())
+        return false;
+
+    DictionaryRecord record;
+    while (parser.next(record))
+        insert(trie, record.word, record.meaning);
+    return true;
+}
+
+// RadixTrie's insert() takes strings, so each record is copied into two reused buffers.
+bool loadTextDictionary(RadixTrie *trie, const std::string &wordFilename, const std::string &meaningFilename)
+{
+    DictionaryParser parser(wordFilename, meaningFilename);
+    if (!parser.isOpen())
+        return false;
+
+    DictionaryRecord record;
+    std::string word, meaning;
+    while (parser.next(record))
+    {
+        word.assign(record.word.data(), record.word.size());
+        meaning.assign(record.meaning.data(), record.meaning.size());
+        insert(trie, word, meaning);
+    }
+    return true;
+}
+
+// Makes a whole file's contents available: mapped when possible, read into `copy` otherwise
+// (e.g. for an empty file, which cannot be mapped). Returns false if the file cannot be opened.
+static bool readFile(const std::string &filename, MappedFile &mapping, std::string &copy, std::string_view &contents)
+{
+    if (mapping.open(filename))
+    {
+        contents = std::string_view(mapping.data(), mapping.size());
+        return true;
+    }
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+    copy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    contents = copy;
+    return true;
+}
+
+// Splits text already in memory into lines, with the parser's rules for the byte order mark and CRLF.
+static std::vector<std::string_view> splitLines(std::string_view text)
+{
+    text = stripByteOrderMark(text);
+    std::vector<std::string_view> lines;
+    lines.reserve(size_t(std::count(text.begin(), text.end(), '\n')) + 1);
+    size_t position = 0;
+    std::string_view line;
+    while (nextLine(text, position, line))
+        lines.push_back(line);
+    return lines;
+}
+
+// Returns the index (0-25) of the first letter of a word, or -1 if it has none.
+static int firstLetter(std::string_view word)
+{
+    for (char ch : word)
+    {
+        int index = letterIndex(ch);
+        if (index >= 0)
+            return index;
+    }
+    return -1;
+}
+
+// Inserts the given records in order.
+static void insertRecords(Trie *trie, const std::vector<uint32_t> &records,
+                          const std::vector<std::string_view> &words, const std::vector<std::string_view> &meanings)
+{
+    for (uint32_t record : records)
+        insert(trie, words[record], meanings[record]);
+}
+
+// Groups the records by first letter (each group in file order, so the last meaning of a repeated
+// word still wins), builds one subtrie per thread for a run of letters, then merges them.
+bool loadTextDictionaryParallel(Trie *trie, const std::string &wordFilename, const std::string &meaningFilename, unsigned threadCount)
+{
+    MappedFile wordFile, meaningFile;
+    std::string wordCopy, meaningCopy;
+    std::string_view wordText, meaningText;
+    if (!readFile(wordFilename, wordFile, wordCopy, wordText) || !readFile(meaningFilename, meaningFile, meaningCopy, meaningText))
+        return false;
+    std::vector<std::string_view> words = splitLines(wordText);
+    std::vector<std::string_view> meanings = splitLines(meaningText);
+    size_t recordCount = words.size() < meanings.size() ? words.size() : meanings.size();
+
+    std::vector<uint32_t> byLetter[ALPHABET_SIZE];
+    std::vector<uint32_t> noLetter; // Words without letters end on the root itself
+    for (size_t record = 0; record < recordCount; record++)
+    {
+        int letter = firstLetter(words[record]);
+        (letter >= 0 ? byLetter[letter] : noLetter).push_back(uint32_t(record));
+    }
+
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount > unsigned(ALPHABET_SIZE))
+        threadCount = ALPHABET_SIZE;
+
+    // Give each thread a run of consecutive letters holding about the same number of records.
+    std::vector<int> firstOfRun(1, 0);
+    size_t target = recordCount / (threadCount > 0 ? threadCount : 1) + 1, runSize = 0;
+    for (int letter = 0; letter < ALPHABET_SIZE; letter++)
+    {
+        runSize += byLetter[letter].size();
+        if (runSize >= target && letter + 1 < ALPHABET_SIZE)
+        {
+            firstOfRun.push_back(letter + 1);
+            runSize = 0;
+        }
+    }
+    firstOfRun.push_back(ALPHABET_SIZE);
+
+    if (firstOfRun.size() == 2)
+    {
+        // A single run: insert straight into the trie, no merge needed.
+        for (int letter = 0; letter < ALPHABET_SIZE; letter++)
+            insertRecords(trie, byLetter[letter], words, meanings);
+    }
+    else
+    {
+        std::vector<Trie *> parts(firstOfRun.size() - 1, nullptr);
+        std::vector<std::thread> workers;
+        for (size_t run = 0; run < parts.size(); run++)
+        {
+            workers.emplace_back([&, run]() {
+                parts[run] = createTrie();
+                for (int letter = firstOfRun[run]; letter < firstOfRun[run + 1]; letter++)
+                    insertRecords(parts[run], byLetter[letter], words, meanings);
+            });
+        }
+        for (std::thread &worker : workers)
+            worker.join();
+        mergeTries(trie, parts);
+    }
+    insertRecords(trie, noLetter, words, meanings);
+    return true;
+}
+
+// The pool's offsets then equal positions in the file: chunk i is the i-th CHUNK_SIZE window of the
+// mapping. An empty meaning file cannot be mapped, and has nothing to leave out, so it is loaded
+// the usual way.
+bool loadTextDictionaryLazy(Trie *trie, const std::string &wordFilename, const std::string &meaningFilename)
+{
+    MappedFile wordFile;
+    std::string wordCopy;
+    std::string_view wordText;
+    if (!readFile(wordFilename, wordFile, wordCopy, wordText))
+        return false;
+    MappedFile &meaningFile = trie->meaningText;
+    if (!meaningFile.open(meaningFilename))
+        return loadTextDictionary(trie, wordFilename, meaningFilename);
+    size_t chunkCount = (meaningFile.size() + MeaningPool::CHUNK_SIZE - 1) / MeaningPool::CHUNK_SIZE;
+    if (chunkCount > (size_t(1) << (32 - MeaningPool::CHUNK_BITS)))
+    {
+        meaningFile.close();
+        return false;
+    }
+
+    std::vector<char *> chunks;
+    std::vector<size_t> chunkLengths;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        chunks.push_back(meaningFile.data() + i * MeaningPool::CHUNK_SIZE);
+        chunkLengths.push_back(std::min(MeaningPool::CHUNK_SIZE, meaningFile.size() - i * MeaningPool::CHUNK_SIZE));
+    }
+    trie->meanings.adopt(chunks, chunkLengths);
+
+    std::vector<std::string_view> words = splitLines(wordText);
+    std::vector<std::string_view> meanings = splitLines(std::string_view(meaningFile.data(), meaningFile.size()));
+    size_t recordCount = std::min(words.size(), meanings.size());
+    for (size_t record = 0; record < recordCount; record++)
+        insertStored(trie, words[record], uint32_t(meanings[record].data() - meaningFile.data()), uint32_t(meanings[record].size()));
+    meaningFile.dropPages();
+    return true;
+}
+
+void releaseLazyMeanings(Trie *trie)
+{
+    trie->meaningText.dropPages();
+}
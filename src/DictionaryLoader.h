@@ -0,0 +1,36 @@
+#ifndef DICTIONARY_LOADER_H
+#define DICTIONARY_LOADER_H
+
+#include <string>
+#include "Trie.h"
+#include "RadixTrie.h"
+
+// Reads the word list and the meaning list (line i of one belongs to line i of the other) and
+// inserts every pair into the trie. Lines are read as DictionaryParser reads them: a byte order
+// mark and the '\r' of CRLF line ends are dropped. Returns false if either file cannot be opened.
+bool loadTextDictionary(Trie *trie, const std::string &wordFilename, const std::string &meaningFilename);
+
+// Same as above, into a path-compressed trie.
+bool loadTextDictionary(RadixTrie *trie, const std::string &wordFilename, const std::string &meaningFilename);
+
+// Same result as loadTextDictionary(), including which meaning wins for a repeated word, but built
+// on several threads: both files are mapped into memory, the records are split by the first letter
+// of the word, each thread builds the subtries for a range of letters, and the subtries are merged
+// into `trie` at the end. `trie` must be empty. A threadCount of 0 uses one thread per core.
+bool loadTextDictionaryParallel(Trie *trie, const std::string &wordFilename, const std::string &meaningFilename, unsigned threadCount = 0);
+
+// Loads the dictionary without reading the meanings into memory: the meaning file is mapped, its
+// lines are split in one scan, and each word is inserted with the offset and length of its line in
+// the mapping, which the trie's meaning pool adopts as its first chunks. The pages read by the scan
+// are then dropped, so a meaning is only read back in, one page, when it is first looked up, and
+// resident memory grows with the words viewed rather than with the dictionary. Runs on one thread,
+// as the parts of loadTextDictionaryParallel() cannot share the mapping's offsets. `trie` must be
+// empty. Returns false if either file cannot be opened, or if the meaning file is too large for
+// the pool's 32-bit offsets.
+bool loadTextDictionaryLazy(Trie *trie, const std::string &wordFilename, const std::string &meaningFilename);
+
+// Drops the pages of a lazily loaded trie's meaning file that have been read since the load, e.g.
+// by indexDefinitions(). Does nothing for other tries.
+void releaseLazyMeanings(Trie *trie);
+
+#endif // DICTIONARY_LOADER_H
@@ -0,0 +1,130 @@
+#include "DictionaryParser.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char BYTE_ORDER_MARK[3] = {'\xEF', '\xBB', '\xBF'};
+
+// Drops the '\r' of a "\r\n" line end.
+static std::string_view trimLineEnd(std::string_view line)
+{
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+LineReader::LineReader(const std::string &path)
+{
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+        buffer.resize(BLOCK_SIZE);
+}
+
+LineReader::~LineReader()
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+// Moves the unread tail to the front of the buffer, doubling the buffer if the tail fills it,
+// then reads the next block behind it. Returns false once nothing more can be read.
+bool LineReader::refill()
+{
+    if (atEnd)
+        return false;
+    if (begin > 0)
+    {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == buffer.size())
+        buffer.resize(buffer.size() * 2); // A line longer than the buffer
+
+    ssize_t count = ::read(fd, buffer.data() + end, buffer.size() - end);
+    if (count <= 0)
+    {
+        atEnd = true;
+        return false;
+    }
+    end += size_t(count);
+
+    if (atStart && end >= sizeof(BYTE_ORDER_MARK) && std::memcmp(buffer.data(), BYTE_ORDER_MARK, sizeof(BYTE_ORDER_MARK)) == 0)
+        begin = sizeof(BYTE_ORDER_MARK);
+    atStart = false;
+    return true;
+}
+
+// memchr() scans for the '\n' with vector instructions, so the block is crossed at memory speed.
+bool LineReader::next(std::string_view &line)
+{
+    if (fd < 0)
+        return false;
+    size_t scanned = begin; // No '\n' before this position
+    for (;;)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(buffer.data() + scanned, '\n', end - scanned));
+        if (newline != nullptr)
+        {
+            size_t lineEnd = size_t(newline - buffer.data());
+            line = trimLineEnd(std::string_view(buffer.data() + begin, lineEnd - begin));
+            begin = lineEnd + 1;
+            return true;
+        }
+        scanned = end - begin; // Where the scan resumes once refill() has moved the tail to the front
+        if (!refill())
+            break;
+    }
+
+    // The last line has no '\n'.
+    if (begin == end)
+        return false;
+    line = trimLineEnd(std::string_view(buffer.data() + begin, end - begin));
+    begin = end;
+    return true;
+}
+
+DictionaryParser::DictionaryParser(const std::string &wordFilename, const std::string &meaningFilename)
+    : words(wordFilename), meanings(meaningFilename)
+{
+}
+
+bool DictionaryParser::next(DictionaryRecord &record)
+{
+    if (!words.next(record.word) || !meanings.next(record.meaning))
+        return false;
+    splitMeaning(record.meaning, record);
+    return true;
+}
+
+bool nextLine(std::string_view text, size_t &position, std::string_view &line)
+{
+    if (position >= text.size())
+        return false;
+    const char *start = text.data() + position;
+    const char *newline = static_cast<const char *>(std::memchr(start, '\n', text.size() - position));
+    size_t length = newline != nullptr ? size_t(newline - start) : text.size() - position;
+    line = trimLineEnd(std::string_view(start, length));
+    position += length + 1;
+    return true;
+}
+
+std::string_view stripByteOrderMark(std::string_view text)
+{
+    if (text.size() >= sizeof(BYTE_ORDER_MARK) && std::memcmp(text.data(), BYTE_ORDER_MARK, sizeof(BYTE_ORDER_MARK)) == 0)
+        text.remove_prefix(sizeof(BYTE_ORDER_MARK));
+    return text;
+}
+
+void splitMeaning(std::string_view meaning, DictionaryRecord &record)
+{
+    size_t bar = meaning.find('|');
+    if (bar == std::string_view::npos)
+    {
+        record.partOfSpeech = std::string_view();
+        record.definition = meaning;
+        return;
+    }
+    record.partOfSpeech = meaning.substr(0, bar);
+    record.definition = meaning.substr(bar + 1);
+}
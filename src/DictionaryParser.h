@@ -0,0 +1,74 @@
+#ifndef DICTIONARY_PARSER_H
+#define DICTIONARY_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reads a text file a large block at a time and hands out its lines as views into the block, so
+// no line is copied. Lines end at '\n'; a '\r' before it is dropped, as is a UTF-8 byte order
+// mark at the start of the file. Like std::getline(), a final '\n' does not start an empty line.
+class LineReader
+{
+public:
+    static constexpr size_t BLOCK_SIZE = size_t(1) << 20; // Bytes read at a time; grows for longer lines
+
+    explicit LineReader(const std::string &path);
+    ~LineReader();
+
+    LineReader(const LineReader &) = delete;
+    LineReader &operator=(const LineReader &) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+
+    // Returns the next line in `line`, or false at the end of the file. The view stays valid
+    // until the next call.
+    bool next(std::string_view &line);
+
+private:
+    bool refill();
+
+    int fd = -1;
+    std::vector<char> buffer;
+    size_t begin = 0, end = 0; // Bytes read but not yet handed out
+    bool atStart = true, atEnd = false;
+};
+
+// One line of the word file with the matching line of the meaning file. meaning.txt lines have
+// the form "partOfSpeech|definition"; a line without '|' is all definition.
+struct DictionaryRecord {
+    std::string_view word;
+    std::string_view meaning;      // The whole meaning line, as stored in the trie
+    std::string_view partOfSpeech; // Before the first '|', or empty
+    std::string_view definition;   // After the first '|', or the whole line
+};
+
+// Reads the word and meaning files in step, one record per line pair, stopping at the end of the
+// shorter file.
+class DictionaryParser
+{
+public:
+    DictionaryParser(const std::string &wordFilename, const std::string &meaningFilename);
+
+    bool isOpen() const { return words.isOpen() && meanings.isOpen(); }
+
+    // Returns the next record, or false at the end. Its views stay valid until the next call.
+    bool next(DictionaryRecord &record);
+
+private:
+    LineReader words, meanings;
+};
+
+// Returns the line starting at `position` in text already in memory and moves `position` past it,
+// with the same line rules as LineReader (pass the text with its byte order mark removed).
+// Returns false at the end of the text.
+bool nextLine(std::string_view text, size_t &position, std::string_view &line);
+
+// Removes a UTF-8 byte order mark from the start of the text, if there is one.
+std::string_view stripByteOrderMark(std::string_view text);
+
+// Splits a meaning line into its part of speech and definition.
+void splitMeaning(std::string_view meaning, DictionaryRecord &record);
+
+#endif // DICTIONARY_PARSER_H
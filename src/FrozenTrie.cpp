@@ -0,0 +1,261 @@
+#include "FrozenTrie.h"
+#include "PartOfSpeech.h"
+#include <algorithm>
+#include <iterator>
+
+static const size_t NOT_FOUND = size_t(-1);
+
+// Compiles the Trie level by level: each node gets the next number, its children are appended to
+// the shape in alphabetical order, and its meaning is copied into the frozen trie's own pool.
+FrozenTrie *freezeTrie(const Trie *trie)
+{
+    FrozenTrie *frozen = new FrozenTrie;
+    std::vector<const TrieNode *> queue;
+    queue.reserve(trie->nodeCount);
+    queue.push_back(nodeAt(trie, trie->root));
+    std::string buffer;
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        const TrieNode *node = queue[i];
+        frozen->terminals.push(node->isEndOfWord);
+        if (node->isEndOfWord)
+        {
+            std::string_view meaning = readMeaning(trie, node, buffer);
+            frozen->meaningOffsets.push_back(frozen->meanings.append(meaning));
+            frozen->meaningLengths.push_back(uint32_t(meaning.size()));
+        }
+        forEachChild(trie, node, [&](int index, TrieNode *child) {
+            frozen->shape.push(true);
+            frozen->labels.push_back(uint8_t(index));
+            queue.push_back(child);
+        });
+        frozen->shape.push(false);
+    }
+    frozen->nodeCount = queue.size();
+    frozen->shape.buildIndex();
+    frozen->terminals.buildIndex();
+    frozen->overlay = createTrie();
+    return frozen;
+}
+
+// Returns the number of node x's first child. The children of x are numbered consecutively from
+// there; for x == nodeCount this is nodeCount, which closes the range of the last node.
+static size_t firstChild(const FrozenTrie *trie, size_t x)
+{
+    size_t start = x == 0 ? 0 : trie->shape.select0(x) + 1; // Where x's run of 1s begins
+    return start - x + 1;                                   // One child per 1 before it, after the root
+}
+
+// Finds the children of node x: `count` nodes numbered from `first`.
+static void childRange(const FrozenTrie *trie, size_t x, size_t &first, size_t &count)
+{
+    size_t start = x == 0 ? 0 : trie->shape.select0(x) + 1;
+    count = trie->shape.nextZero(start) - start;
+    first = start - x + 1;
+}
+
+// Walks the frozen nodes along the key, skipping non-letters as insert() does. Returns the number of
+// the node it ends on, or NOT_FOUND.
+static size_t findNode(const FrozenTrie *trie, const std::string &key)
+{
+    size_t x = 0;
+    for (char ch : key)
+    {
+        int index = letterIndex(ch);
+        if (index < 0)
+            continue;
+        size_t first, count;
+        childRange(trie, x, first, count);
+        const uint8_t *labels = trie->labels.data() + first - 1; // Sorted, since children are added in order
+        const uint8_t *found = std::lower_bound(labels, labels + count, uint8_t(index));
+        if (found == labels + count || *found != index)
+            return NOT_FOUND;
+        x = first + size_t(found - labels);
+    }
+    return x;
+}
+
+// Returns the number of frozen words in [from, to) that were removed since freezing.
+static size_t removedBetween(const FrozenTrie *trie, size_t from, size_t to)
+{
+    if (trie->removedWords.empty())
+        return 0;
+    return size_t(std::lower_bound(trie->removedWords.begin(), trie->removedWords.end(), to) -
+                  std::lower_bound(trie->removedWords.begin(), trie->removedWords.end(), from));
+}
+
+// Returns the index of the live frozen word ending at node x, or NOT_FOUND.
+static size_t wordIndex(const FrozenTrie *trie, size_t x)
+{
+    if (x == NOT_FOUND || !trie->terminals.get(x))
+        return NOT_FOUND;
+    size_t index = trie->terminals.rank1(x);
+    return removedBetween(trie, index, index + 1) == 0 ? index : NOT_FOUND;
+}
+
+// Counts the live frozen words below node x. Each level of x's subtree is a consecutive range of
+// node numbers, so this costs a few rank/select steps per level instead of a subtree walk.
+static size_t countFrozen(const FrozenTrie *trie, size_t x)
+{
+    size_t count = 0;
+    for (size_t lo = x, hi = x + 1; lo < hi; lo = firstChild(trie, lo), hi = firstChild(trie, hi))
+    {
+        size_t from = trie->terminals.rank1(lo), to = trie->terminals.rank1(hi);
+        count += (to - from) - removedBetween(trie, from, to);
+    }
+    return count;
+}
+
+// Depth-first walk below frozen node x in alphabetical order, extending `word` in place. Subtrees
+// that lie before `offset` are skipped by counting their words.
+static void collectFrozen(const FrozenTrie *trie, size_t x, std::string &word, size_t &offset, size_t limit, std::vector<std::string> &completions)
+{
+    if (wordIndex(trie, x) != NOT_FOUND)
+    {
+        if (offset > 0)
+            offset--; // Still skipping towards the requested offset
+        else
+            completions.push_back(word);
+    }
+    size_t first, count;
+    childRange(trie, x, first, count);
+    for (size_t child = first; child < first + count && completions.size() < limit; child++)
+    {
+        if (offset > 0)
+        {
+            size_t words = countFrozen(trie, child);
+            if (offset >= words)
+            {
+                offset -= words; // The whole subtree lies before the offset
+                continue;
+            }
+        }
+        word.push_back(char('a' + trie->labels[child - 1]));
+        collectFrozen(trie, child, word, offset, limit, completions);
+        word.pop_back();
+    }
+}
+
+// Collects up to `limit` frozen completions of the prefix after skipping `offset` of them.
+static std::vector<std::string> frozenCompletions(const FrozenTrie *trie, const std::string &prefix, size_t limit, size_t offset)
+{
+    std::vector<std::string> completions;
+    size_t x = findNode(trie, prefix);
+    if (x == NOT_FOUND || limit == 0)
+        return completions;
+    std::string word = prefix;
+    collectFrozen(trie, x, word, offset, limit, completions);
+    return completions;
+}
+
+// Marks a frozen word as removed, keeping the list sorted.
+static void markRemoved(FrozenTrie *trie, size_t index)
+{
+    trie->removedWords.insert(std::lower_bound(trie->removedWords.begin(), trie->removedWords.end(), uint32_t(index)), uint32_t(index));
+}
+
+// Inserts the word into the overlay. A frozen copy of it is marked removed so the overlay's meaning wins.
+void insert(FrozenTrie *trie, const std::string &word, const std::string &meaning)
+{
+    size_t index = wordIndex(trie, findNode(trie, word));
+    if (index != NOT_FOUND)
+        markRemoved(trie, index);
+    insert(trie->overlay, word, meaning);
+}
+
+// Searches the overlay and the frozen words.
+bool search(const FrozenTrie *trie, const std::string &word)
+{
+    return search(trie->overlay, word) || wordIndex(trie, findNode(trie, word)) != NOT_FOUND;
+}
+
+// Returns the meaning from the overlay if the word is there, else from the frozen words.
+std::string_view getMeaning(const FrozenTrie *trie, const std::string &word)
+{
+    if (search(trie->overlay, word))
+        return getMeaning(trie->overlay, word);
+    size_t index = wordIndex(trie, findNode(trie, word));
+    if (index == NOT_FOUND)
+        return std::string_view();
+    return trie->meanings.get(trie->meaningOffsets[index], trie->meaningLengths[index]);
+}
+
+// Merges the frozen and overlay completions, which never share a word, in alphabetical order.
+std::vector<std::string> getCompletions(const FrozenTrie *trie, const std::string &prefix, size_t limit, size_t offset)
+{
+    if (countWords(trie->overlay, prefix) == 0)
+        return frozenCompletions(trie, prefix, limit, offset); // Usual case: the offset can skip subtrees
+
+    std::vector<std::string> frozen = frozenCompletions(trie, prefix, offset + limit, 0);
+    std::vector<std::string> added = getCompletions(trie->overlay, prefix, offset + limit, 0);
+    std::vector<std::string> merged;
+    merged.reserve(frozen.size() + added.size());
+    std::merge(frozen.begin(), frozen.end(), added.begin(), added.end(), std::back_inserter(merged));
+    if (offset >= merged.size())
+        return {};
+    merged.erase(merged.begin(), merged.begin() + offset);
+    if (merged.size() > limit)
+        merged.resize(limit);
+    return merged;
+}
+
+std::vector<std::string> getFilteredCompletions(const FrozenTrie *trie, const std::string &prefix, uint8_t partsOfSpeech, size_t limit)
+{
+    const size_t PAGE = 256;
+    std::vector<std::string> matches;
+    for (size_t offset = 0; matches.size() < limit; offset += PAGE)
+    {
+        std::vector<std::string> page = getCompletions(trie, prefix, PAGE, offset);
+        for (size_t i = 0; i < page.size() && matches.size() < limit; i++)
+        {
+            if (parsePartsOfSpeech(getMeaning(trie, page[i])) & partsOfSpeech)
+                matches.push_back(std::move(page[i]));
+        }
+        if (page.size() < PAGE)
+            break;
+    }
+    return matches;
+}
+
+// Returns the number of frozen and overlay words that share the given prefix.
+size_t countWords(const FrozenTrie *trie, const std::string &prefix)
+{
+    size_t x = findNode(trie, prefix);
+    return (x != NOT_FOUND ? countFrozen(trie, x) : 0) + countWords(trie->overlay, prefix);
+}
+
+// Removes the word from the overlay, or marks its frozen copy as removed.
+bool remove(FrozenTrie *trie, const std::string &word)
+{
+    if (remove(trie->overlay, word))
+        return true;
+    size_t index = wordIndex(trie, findNode(trie, word));
+    if (index == NOT_FOUND)
+        return false;
+    markRemoved(trie, index);
+    return true;
+}
+
+// Reports the frozen arrays as node memory, plus whatever the overlay uses.
+TrieMemoryUsage getMemoryUsage(const FrozenTrie *trie)
+{
+    TrieMemoryUsage usage = getMemoryUsage(trie->overlay);
+    size_t frozenBytes = trie->shape.bytesUsed() + trie->labels.size() + trie->terminals.bytesUsed() +
+                         (trie->meaningOffsets.size() + trie->meaningLengths.size() + trie->removedWords.size()) * sizeof(uint32_t);
+    usage.nodeCount += trie->nodeCount;
+    usage.nodeBytesUsed += frozenBytes;
+    usage.nodeBytesReserved += frozenBytes;
+    usage.meaningBytesUsed += trie->meanings.bytesUsed();
+    usage.meaningBytesReserved += trie->meanings.bytesReserved();
+    return usage;
+}
+
+// Deletes the overlay, then the frozen trie with its meaning pool.
+void deleteTrie(FrozenTrie *&trie)
+{
+    if (!trie)
+        return;
+    deleteTrie(trie->overlay);
+    delete trie;
+    trie = nullptr;
+}
@@ -0,0 +1,68 @@
+#ifndef FROZEN_TRIE_H
+#define FROZEN_TRIE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BitVector.h"
+#include "MeaningPool.h"
+#include "Trie.h"
+
+// Read-only, succinct (LOUDS) encoding of a Trie. Nodes are numbered in level order, root first;
+// for each node the shape bit string holds one 1 per child followed by a 0, so a node's children
+// are found with one select and have consecutive numbers. Per node this costs about 2 shape bits,
+// a label byte and a terminal bit, plus 8 bytes per word for its meaning's location.
+//
+// Words added, replaced or removed after freezing go to a small mutable overlay: the overlay Trie
+// holds new and replaced words, and replaced or removed frozen words are listed as removed, so the
+// two never hold the same word.
+struct FrozenTrie {
+    BitVector shape;                      // LOUDS bits: for each node in level order, 1 per child then 0
+    std::vector<uint8_t> labels;          // Letter (0-25) on the edge into each node but the root
+    BitVector terminals;                  // Bit per node, set where a word ends
+    std::vector<uint32_t> meaningOffsets; // Per frozen word in level order, into `meanings`
+    std::vector<uint32_t> meaningLengths;
+    MeaningPool meanings;
+    size_t nodeCount = 0;
+    std::vector<uint32_t> removedWords; // Sorted indices of frozen words removed or replaced since freezing
+    Trie *overlay = nullptr;            // Words added or replaced since freezing
+};
+
+// Compiles a Trie into a frozen trie with an empty overlay. The Trie is left unchanged.
+FrozenTrie *freezeTrie(const Trie *trie);
+
+// The operations below behave like their Trie counterparts in Trie.h, over the frozen words and
+// the overlay together.
+
+// Adds a word to the overlay, hiding a frozen word of the same spelling.
+void insert(FrozenTrie *trie, const std::string &word, const std::string &meaning);
+
+// Checks if a word exists in the trie.
+bool search(const FrozenTrie *trie, const std::string &word);
+
+// Returns the meaning of the word if it exists; otherwise, returns an empty view.
+std::string_view getMeaning(const FrozenTrie *trie, const std::string &word);
+
+// Returns up to `limit` words that share the given prefix, in alphabetical order,
+// skipping the first `offset` matches.
+std::vector<std::string> getCompletions(const FrozenTrie *trie, const std::string &prefix, size_t limit, size_t offset = 0);
+
+// Returns up to `limit` words that share the given prefix and have one of the given parts of
+// speech, in alphabetical order. The frozen trie keeps no part-of-speech masks, so the matches
+// are read a page at a time and each one's meaning is parsed.
+std::vector<std::string> getFilteredCompletions(const FrozenTrie *trie, const std::string &prefix, uint8_t partsOfSpeech, size_t limit);
+
+// Returns the number of words that share the given prefix.
+size_t countWords(const FrozenTrie *trie, const std::string &prefix);
+
+// Removes a word from the overlay or marks a frozen word as removed. Returns true if the word was present.
+bool remove(FrozenTrie *trie, const std::string &word);
+
+// Reports the memory used by the frozen arrays and the overlay together.
+TrieMemoryUsage getMemoryUsage(const FrozenTrie *trie);
+
+// Deletes the frozen trie and its overlay.
+void deleteTrie(FrozenTrie *&trie);
+
+#endif // FROZEN_TRIE_H
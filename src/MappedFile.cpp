@@ -0,0 +1,50 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+// Maps the whole file copy-on-write. The descriptor is not needed once the mapping exists.
+bool MappedFile::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        mapping = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    bytes = static_cast<char *>(mapping);
+    length = size_t(info.st_size);
+    return true;
+}
+
+// Private pages that were never written are still the file's, so they can be dropped and faulted
+// back in later.
+void MappedFile::dropPages()
+{
+    if (bytes == nullptr)
+        return;
+    madvise(bytes, length, MADV_RANDOM);
+    madvise(bytes, length, MADV_DONTNEED);
+}
+
+// Unmaps the file; pages that were written are discarded.
+void MappedFile::close()
+{
+    if (bytes != nullptr)
+        munmap(bytes, length);
+    bytes = nullptr;
+    length = 0;
+}
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped into memory. The mapping is private: its pages can be written, but writes
+// are copied on demand and never reach the file. The mapping is removed by close() or the destructor.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps the file, replacing any previous mapping. Returns false if it cannot be opened or mapped.
+    bool open(const std::string &path);
+
+    void close();
+
+    // Drops the pages read so far and turns off read-ahead, so that from then on only the pages
+    // actually touched are read back in from the file, one at a time. Changes written to the
+    // mapping are lost.
+    void dropPages();
+
+    char *data() const { return bytes; }
+    size_t size() const { return length; }
+    bool isOpen() const { return bytes != nullptr; }
+
+private:
+    char *bytes = nullptr;
+    size_t length = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,215 @@
+#include "MeaningCodec.h"
+#include <algorithm>
+#include <unordered_map>
+
+// Code units seen while training: the 256 bytes, which an untrained table escapes, then the symbols.
+static const size_t TRAINING_UNITS = 256 + MeaningCodec::MAX_SYMBOLS;
+
+// Keeps the low `length` bytes of a word.
+static inline uint64_t lowBytes(uint64_t word, size_t length)
+{
+    return length >= 8 ? word : word & ((uint64_t(1) << (8 * length)) - 1);
+}
+
+static inline size_t hashSlot(uint64_t word)
+{
+    uint32_t firstThree = uint32_t(word & 0xFFFFFF);
+    return (firstThree * 0x9E3779B1u) >> (32 - MeaningCodec::HASH_BITS);
+}
+
+// A candidate symbol while training: its bytes and their number.
+struct Candidate {
+    uint64_t symbol;
+    size_t length;
+    bool operator==(const Candidate &other) const { return symbol == other.symbol && length == other.length; }
+};
+
+struct CandidateHash {
+    size_t operator()(const Candidate &candidate) const { return std::hash<uint64_t>()(candidate.symbol * 9 + candidate.length); }
+};
+
+// Drops every symbol and leaves empty encoding tables, in which every byte is escaped.
+void MeaningCodec::clearEncoder()
+{
+    count = 0;
+    hash.assign(size_t(1) << HASH_BITS, Slot{0, 0, 0});
+    shortCodes.assign(size_t(1) << 16, uint16_t(1 << 8 | ESCAPE));
+    singleCodes.assign(256, uint16_t(1 << 8 | ESCAPE));
+}
+
+// A symbol of 3 or more bytes needs its hash slot to itself; one whose slot is taken is skipped.
+bool MeaningCodec::add(uint64_t symbol, size_t length)
+{
+    if (count >= MAX_SYMBOLS || (length >= 3 && hash[hashSlot(symbol)].length != 0))
+        return false;
+    symbols[count] = symbol;
+    lengths[count] = uint8_t(length);
+    index(uint8_t(count));
+    count++;
+    return true;
+}
+
+// Enters a symbol into the encoding tables. A single byte fills in every pair starting with it
+// that no 2-byte symbol has taken, so symbols must be indexed in the order they were added.
+void MeaningCodec::index(uint8_t code)
+{
+    uint64_t symbol = symbols[code];
+    size_t length = lengths[code];
+    if (length >= 3)
+        hash[hashSlot(symbol)] = Slot{symbol, uint8_t(length), code};
+    else if (length == 1)
+    {
+        singleCodes[symbol & 0xFF] = uint16_t(1 << 8 | code);
+        for (size_t next = 0; next < 256; next++)
+        {
+            uint16_t &entry = shortCodes[next << 8 | (symbol & 0xFF)];
+            if ((entry >> 8) < 2)
+                entry = uint16_t(1 << 8 | code);
+        }
+    }
+    else
+        shortCodes[symbol & 0xFFFF] = uint16_t(2 << 8 | code);
+}
+
+// Builds the released tables again from the symbols, in code order, so they come out the same.
+void MeaningCodec::buildEncoder()
+{
+    size_t symbolCount = count;
+    clearEncoder();
+    count = symbolCount;
+    for (size_t code = 0; code < count; code++)
+        index(uint8_t(code));
+}
+
+void MeaningCodec::releaseEncoder()
+{
+    std::vector<Slot>().swap(hash);
+    std::vector<uint16_t>().swap(shortCodes);
+    std::vector<uint16_t>().swap(singleCodes);
+}
+
+uint8_t MeaningCodec::match(const unsigned char *text, size_t remaining, size_t &length) const
+{
+    uint64_t word = 0;
+    std::memcpy(&word, text, remaining < 8 ? remaining : 8);
+    if (remaining >= 3)
+    {
+        const Slot &slot = hash[hashSlot(word)];
+        if (slot.length != 0 && slot.length <= remaining && lowBytes(word, slot.length) == slot.symbol)
+        {
+            length = slot.length;
+            return slot.code;
+        }
+    }
+    uint16_t entry = remaining >= 2 ? shortCodes[word & 0xFFFF] : singleCodes[word & 0xFF];
+    length = entry >> 8;
+    return uint8_t(entry);
+}
+
+// Each round encodes the sample with the current table and counts every code unit and every pair
+// of adjacent units. A unit, or a pair joined into one symbol of at most 8 bytes, is worth the bytes
+// it would cover; the next table takes the candidates worth the most. Symbols thus grow by joining
+// over the rounds, and ones that lose out to longer symbols drop away.
+void MeaningCodec::train(const std::vector<std::string_view> &texts)
+{
+    size_t totalBytes = 0;
+    for (std::string_view text : texts)
+        totalBytes += text.size();
+    size_t stride = totalBytes / SAMPLE_BYTES + 1;
+    std::vector<std::string_view> sample;
+    for (size_t i = 0; i < texts.size(); i += stride)
+        sample.push_back(texts[i]);
+
+    clearEncoder();
+    std::vector<uint32_t> singles(TRAINING_UNITS);
+    std::vector<uint32_t> pairs(TRAINING_UNITS * TRAINING_UNITS);
+    std::unordered_map<Candidate, uint64_t, CandidateHash> gains;
+    for (int round = 0; round < TRAINING_ROUNDS; round++)
+    {
+        std::fill(singles.begin(), singles.end(), 0);
+        std::fill(pairs.begin(), pairs.end(), 0);
+        for (std::string_view text : sample)
+        {
+            const unsigned char *position = reinterpret_cast<const unsigned char *>(text.data());
+            size_t remaining = text.size(), previous = TRAINING_UNITS;
+            while (remaining > 0)
+            {
+                size_t length;
+                uint8_t code = match(position, remaining, length);
+                size_t unit = code == ESCAPE ? *position : 256 + code;
+                singles[unit]++;
+                if (previous < TRAINING_UNITS)
+                    pairs[previous * TRAINING_UNITS + unit]++;
+                previous = unit;
+                position += length;
+                remaining -= length;
+            }
+        }
+
+        auto unitSymbol = [&](size_t unit, size_t &length) {
+            length = unit < 256 ? 1 : lengths[unit - 256];
+            return unit < 256 ? uint64_t(unit) : symbols[unit - 256];
+        };
+        gains.clear();
+        for (size_t first = 0; first < TRAINING_UNITS; first++)
+        {
+            if (singles[first] == 0)
+                continue;
+            size_t firstLength;
+            uint64_t firstSymbol = unitSymbol(first, firstLength);
+            gains[Candidate{firstSymbol, firstLength}] += uint64_t(singles[first]) * firstLength;
+            for (size_t second = 0; second < TRAINING_UNITS; second++)
+            {
+                uint32_t seen = pairs[first * TRAINING_UNITS + second];
+                size_t secondLength;
+                uint64_t secondSymbol = unitSymbol(second, secondLength);
+                if (seen == 0 || firstLength + secondLength > 8)
+                    continue;
+                Candidate joined{firstSymbol | secondSymbol << (8 * firstLength), firstLength + secondLength};
+                gains[joined] += uint64_t(seen) * joined.length;
+            }
+        }
+
+        // Most valuable first; longer, then lower symbols first among equals, so training is repeatable.
+        std::vector<std::pair<uint64_t, Candidate>> ranked;
+        ranked.reserve(gains.size());
+        for (const auto &gain : gains)
+            ranked.push_back({gain.second, gain.first});
+        std::sort(ranked.begin(), ranked.end(), [](const std::pair<uint64_t, Candidate> &a, const std::pair<uint64_t, Candidate> &b) {
+            if (a.first != b.first)
+                return a.first > b.first;
+            if (a.second.length != b.second.length)
+                return a.second.length > b.second.length;
+            return a.second.symbol < b.second.symbol;
+        });
+        clearEncoder();
+        for (size_t i = 0; i < ranked.size() && count < MAX_SYMBOLS; i++)
+            add(ranked[i].second.symbol, ranked[i].second.length);
+    }
+    isTrained = true;
+}
+
+// One code per symbol matched, two for an escaped byte.
+void MeaningCodec::encode(std::string_view text, std::string &out)
+{
+    if (hash.empty())
+        buildEncoder();
+    const unsigned char *position = reinterpret_cast<const unsigned char *>(text.data());
+    size_t remaining = text.size();
+    while (remaining > 0)
+    {
+        size_t length;
+        uint8_t code = match(position, remaining, length);
+        out.push_back(char(code));
+        if (code == ESCAPE)
+            out.push_back(char(*position));
+        position += length;
+        remaining -= length;
+    }
+}
+
+size_t MeaningCodec::tableBytes() const
+{
+    return sizeof(symbols) + sizeof(lengths) + hash.capacity() * sizeof(Slot) +
+           (shortCodes.capacity() + singleCodes.capacity()) * sizeof(uint16_t);
+}
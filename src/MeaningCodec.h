@@ -0,0 +1,94 @@
+#ifndef MEANING_CODEC_H
+#define MEANING_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Static symbol-table compression for meanings, after FSST (Boncz, Neumann, Leis, "FSST: Fast
+// Random Access String Compression"). Up to MAX_SYMBOLS symbols of 1 to 8 bytes are chosen by
+// training on a sample of the strings; a string is then encoded as one byte per symbol, with
+// ESCAPE followed by the byte itself for a byte no symbol covers. Every string is encoded on its
+// own, so any one of them is decoded without the others, by copying 8 bytes per code.
+//
+// Symbols of 3 or more bytes are found through a hash of their first 3 bytes, one symbol per
+// slot; shorter ones through a table indexed by the next 2 bytes. These encoding tables take about
+// 195 kB, so once a batch of strings is encoded they can be freed with releaseEncoder(); decoding
+// only needs the symbols themselves (2.3 kB), and the next encode() builds the tables again.
+// Symbols are kept as 64-bit words in memory order, so the tables assume a little-endian machine.
+class MeaningCodec
+{
+public:
+    static constexpr size_t MAX_SYMBOLS = 255;
+    static constexpr uint8_t ESCAPE = 255;
+    static constexpr size_t HASH_BITS = 12;          // Slots for symbols of 3 or more bytes
+    static constexpr size_t SAMPLE_BYTES = 1 << 18;  // Training text, taken from strings spread over the input
+    static constexpr int TRAINING_ROUNDS = 5;
+
+    // Chooses the symbols for the given strings, replacing any previous table.
+    void train(const std::vector<std::string_view> &texts);
+
+    // True once a table has been trained; until then nothing can be encoded.
+    bool trained() const { return isTrained; }
+
+    // Appends the encoding of `text` to `out`. Builds the encoding tables first if they were released.
+    void encode(std::string_view text, std::string &out);
+
+    // Frees the encoding tables, keeping what decode() needs.
+    void releaseEncoder();
+
+    // Decodes an encoded string into `buffer` and returns a view of the text. The buffer is only
+    // ever grown, so decoding into the same one again allocates nothing.
+    std::string_view decode(std::string_view code, std::string &buffer) const
+    {
+        if (buffer.size() < code.size() * 8 + 8)
+            buffer.resize(code.size() * 8 + 8);
+        char *out = &buffer[0];
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(code.data());
+        const unsigned char *end = in + code.size();
+        while (in < end)
+        {
+            unsigned c = *in++;
+            if (c != ESCAPE)
+            {
+                std::memcpy(out, &symbols[c], 8); // Bytes past the symbol's length are overwritten next
+                out += lengths[c];
+            }
+            else if (in < end)
+                *out++ = char(*in++);
+        }
+        return std::string_view(buffer.data(), size_t(out - buffer.data()));
+    }
+
+    size_t symbolCount() const { return count; }
+    size_t tableBytes() const; // Memory held by the symbols and, unless released, the encoding tables
+
+private:
+    struct Slot {
+        uint64_t symbol;
+        uint8_t length; // 0 for an empty slot
+        uint8_t code;
+    };
+
+    // Finds the longest symbol the hash and the short table offer at `text`, with `remaining`
+    // bytes left. Returns its code and sets `length`; ESCAPE with a length of 1 if none fits.
+    uint8_t match(const unsigned char *text, size_t remaining, size_t &length) const;
+
+    bool add(uint64_t symbol, size_t length);
+    void index(uint8_t code);
+    void clearEncoder();
+    void buildEncoder();
+
+    uint64_t symbols[256] = {};  // Symbol of each code, its unused high bytes zero
+    uint8_t lengths[256] = {};
+    size_t count = 0;
+    bool isTrained = false;
+    std::vector<Slot> hash;            // Symbols of 3 to 8 bytes, by a hash of their first 3 bytes
+    std::vector<uint16_t> shortCodes;  // By the next 2 bytes: length << 8 | code of the best 1- or 2-byte symbol
+    std::vector<uint16_t> singleCodes; // By the next byte: the same for a single byte, for the end of a string
+};
+
+#endif // MEANING_CODEC_H
@@ -0,0 +1,91 @@
+#include "MeaningPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+MeaningPool::MeaningPool()
+    : chunkUsed(CHUNK_SIZE), usedBytes(0), reservedBytes(0)
+{
+}
+
+MeaningPool::~MeaningPool()
+{
+    release();
+}
+
+// Appends the text to the current chunk, opening a new chunk when it does not fit.
+uint32_t MeaningPool::append(std::string_view text)
+{
+    if (text.empty())
+        return 0;
+
+    if (text.size() > CHUNK_SIZE - chunkUsed)
+    {
+        // Open a new chunk. A string longer than a chunk gets an exact-size chunk of its own,
+        // which is then full, so the next append opens a regular chunk again.
+        assert(chunks.size() < (size_t(1) << (32 - CHUNK_BITS)));
+        size_t size = text.size() > CHUNK_SIZE ? text.size() : CHUNK_SIZE;
+        char *chunk = static_cast<char *>(std::malloc(size));
+        if (chunk == nullptr)
+            return 0;
+        chunks.push_back(chunk);
+        chunkLengths.push_back(0);
+        chunkUsed = 0;
+        reservedBytes += size;
+    }
+
+    uint32_t offset = (uint32_t(chunks.size() - 1) << CHUNK_BITS) | uint32_t(chunkUsed);
+    std::memcpy(chunks.back() + chunkUsed, text.data(), text.size());
+    chunkUsed = std::min(chunkUsed + text.size(), CHUNK_SIZE);
+    chunkLengths.back() += text.size();
+    usedBytes += text.size();
+    return offset;
+}
+
+// Frees every chunk.
+void MeaningPool::release()
+{
+    for (size_t i = borrowedChunks; i < chunks.size(); i++)
+        std::free(chunks[i]);
+    chunks.clear();
+    chunkLengths.clear();
+    borrowedChunks = 0;
+    chunkUsed = CHUNK_SIZE;
+    usedBytes = 0;
+    reservedBytes = 0;
+}
+
+// Installs borrowed chunks; the pool then reports them as used and reserved.
+void MeaningPool::adopt(const std::vector<char *> &borrowed, const std::vector<size_t> &lengths)
+{
+    assert(chunks.empty() && borrowed.size() == lengths.size());
+    chunks = borrowed;
+    chunkLengths = lengths;
+    borrowedChunks = borrowed.size();
+    chunkUsed = CHUNK_SIZE;
+    usedBytes = 0;
+    for (size_t length : lengths)
+        usedBytes += length;
+    reservedBytes = usedBytes;
+}
+
+// Appends the other pool's chunks; appending continues in its last chunk.
+uint32_t MeaningPool::absorb(MeaningPool &other)
+{
+    assert(other.borrowedChunks == 0);
+    uint32_t delta = uint32_t(chunks.size() << CHUNK_BITS);
+    if (other.chunks.empty())
+        return delta;
+    assert(chunks.size() + other.chunks.size() <= (size_t(1) << (32 - CHUNK_BITS)));
+
+    chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+    chunkLengths.insert(chunkLengths.end(), other.chunkLengths.begin(), other.chunkLengths.end());
+    chunkUsed = other.chunkUsed;
+    usedBytes += other.usedBytes;
+    reservedBytes += other.reservedBytes;
+
+    other.chunks.clear();
+    other.release();
+    return delta;
+}
@@ -0,0 +1,68 @@
+#ifndef MEANING_POOL_H
+#define MEANING_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Append-only byte pool that stores every definition once, back to back. A stored string is
+// identified by a 32-bit offset and its length; the upper bits of the offset select a chunk and
+// the lower CHUNK_BITS the position inside it. Chunks never move, so views returned by get()
+// stay valid until release(). A string longer than a chunk gets a chunk of its own.
+class MeaningPool
+{
+public:
+    static constexpr uint32_t CHUNK_BITS = 20; // 1 MiB chunks, up to 4096 of them
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+    MeaningPool();
+    ~MeaningPool();
+
+    MeaningPool(const MeaningPool &) = delete;
+    MeaningPool &operator=(const MeaningPool &) = delete;
+
+    // Copies the text into the pool and returns its offset.
+    uint32_t append(std::string_view text);
+
+    // Returns a view of a string previously stored with append().
+    std::string_view get(uint32_t offset, uint32_t length) const
+    {
+        if (length == 0)
+            return std::string_view();
+        return std::string_view(chunks[offset >> CHUNK_BITS] + (offset & (CHUNK_SIZE - 1)), length);
+    }
+
+    // Sizes the chunk table for the most chunks an offset can address, so opening a chunk never
+    // moves it. After this, another thread may call get() while one thread appends.
+    void reserveChunkTable() { chunks.reserve(size_t(1) << (32 - CHUNK_BITS)); }
+
+    // Frees all chunks in one step.
+    void release();
+
+    // Takes over chunks that live in memory the pool does not own (e.g. a mapped dictionary image).
+    // The pool must be empty. Adopted chunks count as full and are never freed; later appends go
+    // to new chunks. Chunks that follow each other in memory may hold strings that run on from
+    // one into the next, as get() only looks at the chunk a string starts in.
+    void adopt(const std::vector<char *> &borrowed, const std::vector<size_t> &lengths);
+
+    // Moves every chunk of another pool (which must not have adopted any) to the end of this one and
+    // leaves the other pool empty. Returns the amount to add to an offset from the other pool.
+    uint32_t absorb(MeaningPool &other);
+
+    const std::vector<char *> &chunkList() const { return chunks; }
+    const std::vector<size_t> &chunkLengthList() const { return chunkLengths; } // Bytes filled in each chunk
+
+    size_t bytesReserved() const { return reservedBytes; } // Chunk memory obtained from the system
+    size_t bytesUsed() const { return usedBytes; }         // Bytes appended so far, including replaced meanings
+
+private:
+    std::vector<char *> chunks; // The last regular-sized chunk is being filled
+    std::vector<size_t> chunkLengths;
+    size_t borrowedChunks = 0; // Leading chunks taken over with adopt(), which release() leaves alone
+    size_t chunkUsed;           // Bytes filled in the current chunk
+    size_t usedBytes;
+    size_t reservedBytes;
+};
+
+#endif // MEANING_POOL_H
@@ -0,0 +1,120 @@
+#include "Metrics.h"
+#include <atomic>
+#include <fstream>
+
+struct MetricCounters {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::atomic<uint64_t> lastNs{0};
+    std::atomic<uint64_t> buckets[METRIC_BUCKETS] = {};
+};
+
+static MetricCounters metrics[METRIC_COUNT];
+static std::atomic<uint64_t> gauges[GAUGE_COUNT];
+
+static const char *METRIC_NAMES[METRIC_COUNT] = {
+    "frame", "getMeaning", "getMeanings", "getSuggestions", "getCompletions", "getFuzzyMatches", "definitionSearch",
+    "querySuggest", "queryLookup", "queryInsert",
+    "loadImage", "loadText", "loadWriteImage", "loadCompress", "loadReplayLog", "loadIndex", "loadRanker",
+    "loadFreeze"};
+
+static const char *GAUGE_NAMES[GAUGE_COUNT] = {"nodeCount", "nodeBytes", "meaningBytes", "wordCount"};
+
+static int bucketOf(uint64_t ns)
+{
+    int bucket = 0;
+    while (ns > 1 && bucket < METRIC_BUCKETS - 1)
+    {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void recordDuration(MetricId id, uint64_t ns)
+{
+    MetricCounters &m = metrics[id];
+    m.count.fetch_add(1, std::memory_order_relaxed);
+    m.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    m.lastNs.store(ns, std::memory_order_relaxed);
+    m.buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = m.maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !m.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void setGauge(GaugeId id, uint64_t value)
+{
+    gauges[id].store(value, std::memory_order_relaxed);
+}
+
+MetricSnapshot metricSnapshot(MetricId id)
+{
+    const MetricCounters &m = metrics[id];
+    MetricSnapshot snapshot;
+    snapshot.count = m.count.load(std::memory_order_relaxed);
+    snapshot.totalNs = m.totalNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = m.maxNs.load(std::memory_order_relaxed);
+    snapshot.lastNs = m.lastNs.load(std::memory_order_relaxed);
+    for (int i = 0; i < METRIC_BUCKETS; i++)
+        snapshot.buckets[i] = m.buckets[i].load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+uint64_t gaugeValue(GaugeId id)
+{
+    return gauges[id].load(std::memory_order_relaxed);
+}
+
+const char *metricName(MetricId id)
+{
+    return METRIC_NAMES[id];
+}
+
+const char *gaugeName(GaugeId id)
+{
+    return GAUGE_NAMES[id];
+}
+
+// The buckets are read one by one while other threads may still record, so their sum can differ
+// slightly from the count; the walk uses the sum.
+uint64_t metricPercentileNs(const MetricSnapshot &snapshot, double fraction)
+{
+    uint64_t total = 0;
+    for (uint64_t bucket : snapshot.buckets)
+        total += bucket;
+    if (total == 0)
+        return 0;
+    uint64_t wanted = uint64_t(fraction * double(total));
+    uint64_t seen = 0;
+    for (int i = 0; i < METRIC_BUCKETS; i++)
+    {
+        seen += snapshot.buckets[i];
+        if (seen > wanted)
+            return uint64_t(1) << (i + 1);
+    }
+    return snapshot.maxNs;
+}
+
+bool dumpMetrics(const std::string &filename)
+{
+    std::ofstream out(filename, std::ios::trunc);
+    out << "{\n  \"metrics\": [\n";
+    for (int id = 0; id < METRIC_COUNT; id++)
+    {
+        MetricSnapshot s = metricSnapshot(MetricId(id));
+        out << "    {\"name\": \"" << METRIC_NAMES[id] << "\", \"count\": " << s.count << ", \"total_ns\": " << s.totalNs
+            << ", \"max_ns\": " << s.maxNs << ", \"last_ns\": " << s.lastNs << ", \"p50_ns\": " << metricPercentileNs(s, 0.5)
+            << ", \"p99_ns\": " << metricPercentileNs(s, 0.99) << ", \"histogram_log2_ns\": [";
+        for (int i = 0; i < METRIC_BUCKETS; i++)
+            out << (i > 0 ? ", " : "") << s.buckets[i];
+        out << "]}" << (id + 1 < METRIC_COUNT ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"gauges\": {";
+    for (int id = 0; id < GAUGE_COUNT; id++)
+        out << (id > 0 ? ", " : "") << "\"" << GAUGE_NAMES[id] << "\": " << gaugeValue(GaugeId(id));
+    out << "}\n}\n";
+    return bool(out);
+}
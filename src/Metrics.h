@@ -0,0 +1,104 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Timed operations. Each keeps a count, total, maximum, last duration and a latency histogram.
+enum MetricId : uint8_t {
+    METRIC_FRAME,              // Whole frame, as raylib measures it
+    METRIC_GET_MEANING,        // getMeaning()
+    METRIC_GET_MEANINGS,       // getMeanings(), per batch
+    METRIC_GET_SUGGESTIONS,    // getSuggestions()
+    METRIC_GET_COMPLETIONS,    // getCompletions(), both overloads
+    METRIC_FUZZY_MATCHES,      // getFuzzyMatches()
+    METRIC_DEFINITION_SEARCH,  // DefinitionIndex::search()
+    METRIC_QUERY_SUGGEST,      // A QUERY_SUGGEST request on the query worker
+    METRIC_QUERY_LOOKUP,       // A QUERY_LOOKUP request on the query worker
+    METRIC_QUERY_INSERT,       // A QUERY_INSERT request on the query worker
+    METRIC_LOAD_IMAGE,         // Startup: mapping dictionary.img
+    METRIC_LOAD_TEXT,          // Startup: loading the text files when there is no usable image
+    METRIC_LOAD_WRITE_IMAGE,   // Startup: saving a fresh image
+    METRIC_LOAD_COMPRESS,      // Startup: compressing the meanings
+    METRIC_LOAD_REPLAY_LOG,    // Startup: replaying and compacting changes.log
+    METRIC_LOAD_INDEX,         // Startup: indexing the definitions
+    METRIC_LOAD_RANKER,        // Startup: scoring words for ranked suggestions
+    METRIC_LOAD_FREEZE,        // Startup: compiling the Trie into a FrozenTrie
+    METRIC_COUNT
+};
+
+// Values set rather than timed.
+enum GaugeId : uint8_t {
+    GAUGE_NODE_COUNT,
+    GAUGE_NODE_BYTES,
+    GAUGE_MEANING_BYTES,
+    GAUGE_WORD_COUNT,
+    GAUGE_COUNT
+};
+
+// Latency histogram buckets: bucket i counts durations in [2^i, 2^(i+1)) ns; bucket 0 also
+// holds durations under 1 ns and the last bucket everything longer.
+const int METRIC_BUCKETS = 40;
+
+// A copy of one metric's counters, taken without stopping the threads that record it.
+struct MetricSnapshot {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint64_t lastNs;
+    uint64_t buckets[METRIC_BUCKETS];
+};
+
+// Recording is lock-free (relaxed atomic adds), so any thread may record or read at any time.
+void recordDuration(MetricId id, uint64_t ns);
+void setGauge(GaugeId id, uint64_t value);
+
+MetricSnapshot metricSnapshot(MetricId id);
+uint64_t gaugeValue(GaugeId id);
+const char *metricName(MetricId id);
+const char *gaugeName(GaugeId id);
+
+// The upper bound of the histogram bucket holding the given fraction (e.g. 0.99) of the durations.
+uint64_t metricPercentileNs(const MetricSnapshot &snapshot, double fraction);
+
+// Writes every metric (with its histogram) and gauge to a JSON file. Returns false if the file
+// cannot be written.
+bool dumpMetrics(const std::string &filename);
+
+// Records the time from construction to destruction.
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(MetricId id) : id(id), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer()
+    {
+        recordDuration(id, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    MetricId id;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Instrumentation for hot paths. Without DICTIONARY_METRICS (set by the build for the app only)
+// these expand to nothing, so the tools and the benchmark run uninstrumented code.
+#ifdef DICTIONARY_METRICS
+#define METRICS_CONCAT_INNER(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_INNER(a, b)
+#define METRICS_SCOPE(id) ScopedTimer METRICS_CONCAT(scopedTimer, __LINE__)(id)
+#define METRICS_RECORD(id, ns) recordDuration(id, ns)
+#define METRICS_GAUGE(id, value) setGauge(id, value)
+const bool METRICS_ENABLED = true;
+#else
+#define METRICS_SCOPE(id) ((void)0)
+#define METRICS_RECORD(id, ns) ((void)sizeof(ns))
+#define METRICS_GAUGE(id, value) ((void)sizeof(value))
+const bool METRICS_ENABLED = false;
+#endif
+
+#endif // METRICS_H
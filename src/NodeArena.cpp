@@ -0,0 +1,116 @@
+#include "NodeArena.h"
+#include <cassert>
+#include <cstdlib>
+
+NodeArena::NodeArena()
+    : slabUsed(SLAB_SIZE), liveBytes(0), freeLists(sizeClass(MAX_BLOCK_SIZE) + 1, NO_NODE)
+{
+}
+
+NodeArena::~NodeArena()
+{
+    release();
+}
+
+// Hands out a block, preferring a previously freed block of the same size class.
+NodeRef NodeArena::allocate(size_t size)
+{
+    assert(size > 0 && size <= MAX_BLOCK_SIZE);
+    size_t sc = sizeClass(size);
+    size_t blockSize = sc * ALIGNMENT;
+
+    if (freeLists[sc] != NO_NODE)
+    {
+        NodeRef ref = freeLists[sc];
+        freeLists[sc] = *static_cast<NodeRef *>(pointer(ref)); // Pop the free list
+        liveBytes += blockSize;
+        return ref;
+    }
+
+    if (slabUsed + blockSize > SLAB_SIZE)
+    {
+        // Start a new slab; the tail of the previous one is left unused.
+        assert(slabs.size() < MAX_SLABS);
+        char *slab = static_cast<char *>(std::malloc(SLAB_SIZE));
+        if (slab == nullptr)
+            return NO_NODE;
+        slabs.push_back(slab);
+        // The first block of the first slab would have handle 0, which means "no node".
+        slabUsed = slabs.size() == 1 ? ALIGNMENT : 0;
+    }
+
+    NodeRef ref = NodeRef((slabs.size() - 1) << OFFSET_BITS) | NodeRef(slabUsed / ALIGNMENT);
+    slabUsed += blockSize;
+    liveBytes += blockSize;
+    return ref;
+}
+
+// Pushes a block onto the free list of its size class.
+void NodeArena::deallocate(NodeRef ref, size_t size)
+{
+    if (ref == NO_NODE)
+        return;
+    size_t sc = sizeClass(size);
+    *static_cast<NodeRef *>(pointer(ref)) = freeLists[sc];
+    freeLists[sc] = ref;
+    liveBytes -= sc * ALIGNMENT;
+}
+
+// Frees every slab; the cost depends on the number of slabs, not on the number of nodes.
+void NodeArena::release()
+{
+    for (size_t i = borrowedSlabs; i < slabs.size(); i++)
+        std::free(slabs[i]);
+    slabs.clear();
+    borrowedSlabs = 0;
+    slabUsed = SLAB_SIZE;
+    liveBytes = 0;
+    for (NodeRef &head : freeLists)
+        head = NO_NODE;
+}
+
+// Installs borrowed slabs and the allocation state saved with them.
+void NodeArena::adopt(const std::vector<char *> &borrowed, size_t lastSlabUsed, size_t bytesInUse, const std::vector<NodeRef> &freeListHeads)
+{
+    assert(slabs.empty() && freeListHeads.size() == freeLists.size());
+    slabs = borrowed;
+    borrowedSlabs = borrowed.size();
+    slabUsed = borrowed.empty() ? SLAB_SIZE : lastSlabUsed;
+    liveBytes = bytesInUse;
+    freeLists = freeListHeads;
+}
+
+// Appends the other arena's slabs. Its free blocks are relinked with rebased handles and put in
+// front of this arena's free lists; carving continues in its last slab.
+NodeRef NodeArena::absorb(NodeArena &other)
+{
+    assert(other.borrowedSlabs == 0);
+    NodeRef delta = NodeRef(slabs.size() << OFFSET_BITS);
+    if (other.slabs.empty())
+        return delta;
+    assert(slabs.size() + other.slabs.size() <= MAX_SLABS);
+
+    for (size_t sc = 0; sc < freeLists.size(); sc++)
+    {
+        NodeRef ref = other.freeLists[sc];
+        if (ref == NO_NODE)
+            continue;
+        NodeRef *link = static_cast<NodeRef *>(other.pointer(ref));
+        while (*link != NO_NODE)
+        {
+            NodeRef next = *link;
+            *link = next + delta;
+            link = static_cast<NodeRef *>(other.pointer(next));
+        }
+        *link = freeLists[sc];
+        freeLists[sc] = ref + delta;
+    }
+
+    slabs.insert(slabs.end(), other.slabs.begin(), other.slabs.end());
+    slabUsed = other.slabUsed;
+    liveBytes += other.liveBytes;
+
+    other.slabs.clear();
+    other.release();
+    return delta;
+}
@@ -0,0 +1,81 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 32-bit handle of a block in a NodeArena: the upper bits select a slab, the lower bits give the
+// position inside it in ALIGNMENT units. Handles do not depend on where the slabs are mapped.
+typedef uint32_t NodeRef;
+
+const NodeRef NO_NODE = 0; // Never handed out; used as the null handle
+
+// Pooled allocator for trie nodes. Blocks are carved from large contiguous slabs in allocation
+// order, so nodes created together (e.g. the nodes of one inserted word) sit next to each other
+// in memory. Blocks given back with deallocate() go on a per-size free list and are reused before
+// new slab space; release() frees every slab at once instead of one node at a time.
+class NodeArena
+{
+public:
+    static constexpr uint32_t SLAB_BITS = 18;                      // 256 KiB slabs
+    static constexpr size_t SLAB_SIZE = size_t(1) << SLAB_BITS;
+    static constexpr size_t ALIGNMENT = 8;                         // Every block is aligned (and sized) to this
+    static constexpr uint32_t OFFSET_BITS = SLAB_BITS - 3;         // Bits of a NodeRef used for the position
+    static constexpr size_t MAX_SLABS = size_t(1) << (32 - OFFSET_BITS);
+    static constexpr size_t MAX_BLOCK_SIZE = 1024;                 // Largest block the arena hands out
+
+    NodeArena();
+    ~NodeArena();
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    // Returns the handle of uninitialized storage for `size` bytes (at most MAX_BLOCK_SIZE).
+    NodeRef allocate(size_t size);
+
+    // Returns a block to the arena; `size` must match the size it was allocated with.
+    void deallocate(NodeRef ref, size_t size);
+
+    // Translates a handle into the address of its block.
+    void *pointer(NodeRef ref) const
+    {
+        return slabs[ref >> OFFSET_BITS] + (size_t(ref & ((uint32_t(1) << OFFSET_BITS) - 1)) * ALIGNMENT);
+    }
+
+    // Sizes the slab table for MAX_SLABS up front, so adding a slab never moves it. After this,
+    // another thread may translate handles with pointer() while one thread allocates.
+    void reserveSlabTable() { slabs.reserve(MAX_SLABS); }
+
+    // Frees all slabs in one step. Every block handed out before becomes invalid.
+    void release();
+
+    // Takes over slabs that live in memory the arena does not own (e.g. a mapped dictionary image),
+    // together with the carving position in the last one and the free lists saved with them. The
+    // arena must be empty. Adopted slabs are written to but never freed; new slabs come from malloc.
+    void adopt(const std::vector<char *> &borrowed, size_t lastSlabUsed, size_t bytesInUse, const std::vector<NodeRef> &freeListHeads);
+
+    // Moves every slab of another arena (which must not have adopted any) to the end of this one,
+    // together with its free blocks, and leaves the other arena empty. Returns the amount to add to
+    // a handle from the other arena to get the same block in this one; NO_NODE stays NO_NODE.
+    NodeRef absorb(NodeArena &other);
+
+    const std::vector<char *> &slabList() const { return slabs; }
+    size_t lastSlabUsed() const { return slabUsed; }
+    const std::vector<NodeRef> &freeListHeads() const { return freeLists; }
+
+    size_t bytesReserved() const { return slabs.size() * SLAB_SIZE; } // Slab memory obtained from the system
+    size_t bytesUsed() const { return liveBytes; }                    // Bytes in blocks currently handed out
+    size_t slabCount() const { return slabs.size(); }
+
+private:
+    static size_t sizeClass(size_t size) { return (size + ALIGNMENT - 1) / ALIGNMENT; }
+
+    std::vector<char *> slabs; // Slabs in allocation order; the last one is being carved
+    size_t slabUsed;           // Bytes carved from the last slab
+    size_t liveBytes;
+    std::vector<NodeRef> freeLists; // Singly linked free blocks, indexed by size class
+    size_t borrowedSlabs = 0;       // Leading slabs taken over with adopt(), which release() leaves alone
+};
+
+#endif // NODE_ARENA_H
@@ -0,0 +1,66 @@
+#include "PartOfSpeech.h"
+#include <cctype>
+
+struct PartOfSpeechEntry {
+    const char *word; // As written in meaning.txt
+    const char *name; // For display
+    PartOfSpeech bit;
+};
+
+static const PartOfSpeechEntry PARTS_OF_SPEECH[] = {
+    {"noun", "Noun", POS_NOUN},
+    {"verb", "Verb", POS_VERB},
+    {"adjective", "Adjective", POS_ADJECTIVE},
+    {"adverb", "Adverb", POS_ADVERB},
+    {"pronoun", "Pronoun", POS_PRONOUN},
+    {"preposition", "Preposition", POS_PREPOSITION},
+    {"conjunction", "Conjunction", POS_CONJUNCTION},
+};
+
+// Returns the bit of a lowercase part of speech word, or 0 for any other word.
+static uint8_t partOfSpeechBit(std::string_view word)
+{
+    for (const PartOfSpeechEntry &entry : PARTS_OF_SPEECH)
+    {
+        if (word == entry.word)
+            return entry.bit;
+    }
+    return 0;
+}
+
+// Splits the field before the '|' into lowercase words and looks each one up.
+uint8_t parsePartsOfSpeech(std::string_view meaning)
+{
+    size_t bar = meaning.find('|');
+    if (bar == std::string_view::npos)
+        return POS_OTHER;
+
+    uint8_t bits = 0;
+    char word[16];
+    size_t length = 0;
+    for (size_t i = 0; i <= bar; i++)
+    {
+        int ch = i < bar ? tolower(static_cast<unsigned char>(meaning[i])) : 0;
+        if (ch >= 'a' && ch <= 'z')
+        {
+            if (length < sizeof(word))
+                word[length] = char(ch);
+            length++;
+            continue;
+        }
+        if (length > 0 && length <= sizeof(word))
+            bits |= partOfSpeechBit(std::string_view(word, length));
+        length = 0;
+    }
+    return bits != 0 ? bits : uint8_t(POS_OTHER);
+}
+
+const char *partOfSpeechName(PartOfSpeech partOfSpeech)
+{
+    for (const PartOfSpeechEntry &entry : PARTS_OF_SPEECH)
+    {
+        if (entry.bit == partOfSpeech)
+            return entry.name;
+    }
+    return "Other";
+}
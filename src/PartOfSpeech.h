@@ -0,0 +1,30 @@
+#ifndef PART_OF_SPEECH_H
+#define PART_OF_SPEECH_H
+
+#include <cstdint>
+#include <string_view>
+
+// Parts of speech as bits, so a word with several ("noun, verb") and a subtree of words can
+// both be described by one byte. Anything not listed (abbreviations, a missing or garbled
+// field) counts as POS_OTHER.
+enum PartOfSpeech : uint8_t {
+    POS_NOUN = 1 << 0,
+    POS_VERB = 1 << 1,
+    POS_ADJECTIVE = 1 << 2,
+    POS_ADVERB = 1 << 3,
+    POS_PRONOUN = 1 << 4,
+    POS_PREPOSITION = 1 << 5,
+    POS_CONJUNCTION = 1 << 6,
+    POS_OTHER = 1 << 7
+};
+
+const uint8_t POS_ANY = 0xff;
+
+// Reads the parts of speech named before the '|' of a meaning line ("verb|...", "noun, verb|...",
+// "auxiliary verb|..."). Returns POS_OTHER if none is recognised.
+uint8_t parsePartsOfSpeech(std::string_view meaning);
+
+// Returns a display name for a single part of speech bit, e.g. "Verb".
+const char *partOfSpeechName(PartOfSpeech partOfSpeech);
+
+#endif // PART_OF_SPEECH_H
@@ -0,0 +1,214 @@
+#include "QueryWorker.h"
+#include "DictionaryLoader.h"
+#include "Metrics.h"
+
+QueryWorker::QueryWorker(Trie *trie, DefinitionIndex *definitions, SuggestionRanker *ranker, bool definitionsIndexed)
+    : trie(trie), frozen(nullptr), definitions(definitions), ranker(ranker), definitionsIndexed(definitionsIndexed)
+{
+    thread = std::thread(&QueryWorker::run, this);
+}
+
+QueryWorker::QueryWorker(FrozenTrie *frozen, DefinitionIndex *definitions, SuggestionRanker *ranker)
+    : trie(nullptr), frozen(frozen), definitions(definitions), ranker(ranker), definitionsIndexed(true)
+{
+    thread = std::thread(&QueryWorker::run, this);
+}
+
+QueryWorker::~QueryWorker()
+{
+    stop();
+}
+
+// Taking the lock between the push and the notify means the worker is either still before its
+// check of the queue (and will see the request) or already waiting (and will be woken).
+uint64_t QueryWorker::post(QueryRequest request)
+{
+    request.sequence = nextSequence;
+    if (!requests.push(request))
+        return 0;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+    return nextSequence++;
+}
+
+void QueryWorker::stop()
+{
+    if (!thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+// The dictionary's size, for the performance overlay; only the worker may read the trie.
+void QueryWorker::publishGauges()
+{
+    TrieMemoryUsage usage = frozen != nullptr ? getMemoryUsage(frozen) : getMemoryUsage(trie);
+    METRICS_GAUGE(GAUGE_NODE_COUNT, usage.nodeCount);
+    METRICS_GAUGE(GAUGE_NODE_BYTES, usage.nodeBytesUsed);
+    METRICS_GAUGE(GAUGE_MEANING_BYTES, usage.meaningBytesUsed);
+    METRICS_GAUGE(GAUGE_WORD_COUNT, frozen != nullptr ? countWords(frozen, "") : nodeAt(trie, trie->root)->wordCount);
+}
+
+// Drains the queue into a batch, answers it, and sleeps when the queue is empty. Within a batch
+// only the newest suggestion request is answered; lookups and inserts are all handled, in order.
+void QueryWorker::run()
+{
+    publishGauges();
+    std::vector<QueryRequest> batch;
+    QueryRequest request;
+    while (!stopping)
+    {
+        batch.clear();
+        while (requests.pop(request))
+            batch.push_back(std::move(request));
+        if (batch.empty())
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this] { return stopping || !requests.empty(); });
+            continue;
+        }
+
+        size_t newestSuggestion = batch.size();
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (batch[i].kind == QUERY_SUGGEST)
+                newestSuggestion = i;
+        }
+        for (size_t i = 0; i < batch.size() && !stopping; i++)
+        {
+            if (batch[i].kind != QUERY_SUGGEST || i == newestSuggestion)
+                process(batch[i]);
+        }
+    }
+}
+
+// Reading every meaning for the index brings a lazily loaded meaning file back into memory, so its
+// pages are dropped again afterwards.
+void QueryWorker::indexDefinitionsOnce()
+{
+    if (definitionsIndexed)
+        return;
+    METRICS_SCOPE(METRIC_LOAD_INDEX);
+    indexDefinitions(*definitions, trie);
+    releaseLazyMeanings(trie);
+    definitionsIndexed = true;
+}
+
+// Suggestions for a request on the words (not the definitions) of a Trie.
+void QueryWorker::suggest(const QueryRequest &request, QueryResult &result)
+{
+    cursorSeek(cursor, trie, request.text);
+    if (request.partsOfSpeech != POS_ANY)
+    {
+        // Word counts cover every part of speech, so the filtered total is not known.
+        result.words = getFilteredCompletions(cursor, request.partsOfSpeech, request.limit);
+        result.totalMatches = result.words.size();
+    }
+    else
+    {
+        // Scrolling asks for the page after the last one, where the iterator was left.
+        result.words = getRankedCompletions(cursor, *ranker, completions, request.limit, request.offset);
+        result.totalMatches = countWords(cursor);
+        result.offset = request.offset;
+    }
+}
+
+// The same from a frozen trie, whose completions skip to the requested row without a cursor.
+void QueryWorker::suggestFrozen(const QueryRequest &request, QueryResult &result)
+{
+    if (request.partsOfSpeech != POS_ANY)
+    {
+        result.words = getFilteredCompletions(frozen, request.text, request.partsOfSpeech, request.limit);
+        result.totalMatches = result.words.size();
+    }
+    else
+    {
+        result.words = getCompletions(frozen, request.text, request.limit, request.offset);
+        result.totalMatches = countWords(frozen, request.text);
+        result.offset = request.offset;
+    }
+}
+
+// The meaning of a word, or an empty string.
+std::string QueryWorker::meaningOf(const std::string &word)
+{
+    if (frozen != nullptr)
+        return std::string(getMeaning(frozen, word));
+    return std::string(getMeaning(trie, word, meaningBuffer));
+}
+
+void QueryWorker::process(QueryRequest &request)
+{
+    METRICS_SCOPE(request.kind == QUERY_SUGGEST ? METRIC_QUERY_SUGGEST : request.kind == QUERY_LOOKUP ? METRIC_QUERY_LOOKUP : METRIC_QUERY_INSERT);
+    QueryResult result;
+    result.sequence = request.sequence;
+    result.kind = request.kind;
+
+    switch (request.kind)
+    {
+    case QUERY_SUGGEST:
+        if (request.text.empty())
+            break;
+        if (request.definitions)
+        {
+            indexDefinitionsOnce();
+            result.words = definitions->search(request.text, request.limit);
+            result.totalMatches = result.words.size();
+        }
+        else if (frozen != nullptr)
+            suggestFrozen(request, result);
+        else
+            suggest(request, result);
+        break;
+
+    case QUERY_LOOKUP:
+        if (request.definitions)
+        {
+            // The first word whose definition contains the text.
+            indexDefinitionsOnce();
+            std::vector<std::string> found = definitions->search(request.text, 1);
+            if (!found.empty())
+            {
+                result.word = found[0];
+                result.meaning = meaningOf(found[0]);
+            }
+        }
+        else
+        {
+            result.meaning = meaningOf(request.text);
+            if (!result.meaning.empty())
+            {
+                result.word = request.text;
+                ranker->addScore(request.text, SuggestionRanker::LOOKUP_SCORE); // Looked-up words rank higher from now on
+            }
+            else if (frozen == nullptr)
+            {
+                // The closest spellings; one edit for short words, which are close to too many others.
+                int maxDistance = request.text.size() <= 4 ? 1 : 2;
+                for (FuzzyMatch &match : getFuzzyMatches(trie, request.text, maxDistance, request.limit))
+                    result.words.push_back(std::move(match.word));
+            }
+        }
+        break;
+
+    case QUERY_INSERT:
+        if (frozen != nullptr)
+            insert(frozen, request.text, request.meaning); // Into the overlay
+        else
+            insert(trie, request.text, request.meaning);
+        if (definitionsIndexed)
+            definitions->add(request.text, request.meaning); // Otherwise the index will find it in the trie
+        publishGauges();
+        return;
+    }
+
+    // The UI drains the results every frame, so a full queue only lasts until its next frame.
+    while (!results.push(result) && !stopping)
+        std::this_thread::yield();
+}
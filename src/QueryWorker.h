@@ -0,0 +1,112 @@
+#ifndef QUERY_WORKER_H
+#define QUERY_WORKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DefinitionIndex.h"
+#include "FrozenTrie.h"
+#include "SpscQueue.h"
+#include "SuggestionRanker.h"
+#include "Trie.h"
+
+enum QueryKind : uint8_t {
+    QUERY_SUGGEST, // Suggestions for the text: completions, or words whose definitions contain it
+    QUERY_LOOKUP,  // The meaning of the text, with close spellings if it is not a word
+    QUERY_INSERT   // Add the text as a word with `meaning`; no result is sent back
+};
+
+struct QueryRequest {
+    uint64_t sequence = 0; // Set by QueryWorker::post()
+    QueryKind kind = QUERY_SUGGEST;
+    bool definitions = false;        // Search the definitions instead of the words
+    uint8_t partsOfSpeech = POS_ANY; // Suggestions: only words with one of these
+    size_t limit = 0;                // Most words to return
+    size_t offset = 0;               // Suggestions in Words mode without a filter: first row of the list to return
+    std::string text;
+    std::string meaning; // For QUERY_INSERT
+};
+
+struct QueryResult {
+    uint64_t sequence = 0; // Of the request this answers
+    QueryKind kind = QUERY_SUGGEST;
+    std::vector<std::string> words; // Suggestions; for a lookup that found nothing, the closest spellings
+    size_t totalMatches = 0;        // Suggestions: how many words match in all, when known
+    size_t offset = 0;              // Suggestions: row of the list the first word is at
+    std::string word;               // Lookup: the word whose meaning was found
+    std::string meaning;            // Lookup: empty if nothing was found
+};
+
+// Runs dictionary queries on a thread of its own so the UI never waits for one. The UI posts
+// requests and polls for results once per frame, over two lock-free single-producer queues.
+// Every request gets a rising sequence number and its result carries it back, so the UI can
+// drop answers to requests it has since replaced (e.g. suggestions for an older keystroke). The
+// worker also skips suggestion requests that a newer one queued behind them has made stale.
+//
+// While the worker runs it is the only thread touching the trie, the definition index and the
+// ranker, so changes to them go through QUERY_INSERT as well.
+//
+// The worker answers from either a Trie or a FrozenTrie. A frozen trie's words go to its overlay
+// when inserted; its suggestions come in alphabetical order, as it has no cursor for the ranker,
+// and a lookup that finds nothing offers no close spellings.
+class QueryWorker
+{
+public:
+    static constexpr size_t QUEUE_SIZE = 256;
+
+    // If `definitionsIndexed` is false, `definitions` is still empty and the worker indexes the trie
+    // when a query first searches the definitions (e.g. for a lazily loaded trie, whose meanings
+    // are not read at startup).
+    QueryWorker(Trie *trie, DefinitionIndex *definitions, SuggestionRanker *ranker, bool definitionsIndexed = true);
+
+    // Answers from a frozen trie. `definitions` must already index its words.
+    QueryWorker(FrozenTrie *frozen, DefinitionIndex *definitions, SuggestionRanker *ranker);
+    ~QueryWorker();
+
+    QueryWorker(const QueryWorker &) = delete;
+    QueryWorker &operator=(const QueryWorker &) = delete;
+
+    // Queues a request and returns its sequence number, or 0 if the queue is full. UI thread only.
+    uint64_t post(QueryRequest request);
+
+    // Takes the next result, if one is ready. UI thread only.
+    bool poll(QueryResult &result) { return results.pop(result); }
+
+    // Stops and joins the worker; requests still queued are dropped. Called by the destructor.
+    void stop();
+
+private:
+    void run();
+    void process(QueryRequest &request);
+    void indexDefinitionsOnce();
+    void publishGauges();
+    void suggest(const QueryRequest &request, QueryResult &result);
+    void suggestFrozen(const QueryRequest &request, QueryResult &result);
+    std::string meaningOf(const std::string &word);
+
+    Trie *trie;
+    FrozenTrie *frozen; // Set instead of `trie` when answering from a frozen trie
+    DefinitionIndex *definitions;
+    SuggestionRanker *ranker;
+    PrefixCursor cursor;            // Worker side: follows the text of the suggestion requests
+    CompletionIterator completions; // Worker side: where the last page of suggestions ended
+    std::string meaningBuffer;      // Worker side: compressed meanings are decoded here
+    bool definitionsIndexed;        // Worker side, after construction
+
+    SpscQueue<QueryRequest, QUEUE_SIZE> requests; // UI -> worker
+    SpscQueue<QueryResult, QUEUE_SIZE> results;   // Worker -> UI
+    uint64_t nextSequence = 1;
+
+    // Only used to let the worker sleep while there is nothing to do; the queues need no lock.
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+#endif // QUERY_WORKER_H
@@ -0,0 +1,425 @@
+#include "RadixTrie.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Returns the child handles of a node.
+static NodeRef *childRefs(RadixNode *node)
+{
+    return reinterpret_cast<NodeRef *>(node + 1);
+}
+
+// Returns the first letter (0-25) of each child's label, in the same order as childRefs().
+static uint8_t *childKeys(RadixNode *node)
+{
+    return reinterpret_cast<uint8_t *>(childRefs(node) + node->capacity);
+}
+
+// Returns the number of bytes a node block takes in the arena.
+static size_t blockSize(size_t capacity, size_t labelLength)
+{
+    return sizeof(RadixNode) + capacity * (sizeof(NodeRef) + 1) + labelLength;
+}
+
+// Creates a node with the given edge label and room for `capacity` children.
+static NodeRef newNode(RadixTrie *trie, std::string_view label, size_t capacity)
+{
+    NodeRef ref = trie->nodes.allocate(blockSize(capacity, label.size()));
+    RadixNode *node = nodeAt(trie, ref);
+    trie->nodeCount++;
+    node->isEndOfWord = false;
+    node->numChildren = 0;
+    node->capacity = uint8_t(capacity);
+    node->labelLength = uint8_t(label.size());
+    node->wordCount = 0;
+    node->meaningOffset = 0;
+    node->meaningLength = 0;
+    if (!label.empty())
+        std::memcpy(const_cast<char *>(nodeLabel(node).data()), label.data(), label.size());
+    return ref;
+}
+
+// Gives a node back to the trie's arena.
+static void freeNode(RadixTrie *trie, NodeRef ref)
+{
+    RadixNode *node = nodeAt(trie, ref);
+    trie->nodes.deallocate(ref, blockSize(node->capacity, node->labelLength));
+    trie->nodeCount--;
+}
+
+// Creates an empty trie with just a root node (which has an empty label).
+RadixTrie *createRadixTrie()
+{
+    RadixTrie *trie = new RadixTrie;
+    trie->root = newNode(trie, std::string_view(), 0);
+    return trie;
+}
+
+// Moves the node in `slot` to a new block with another label and child capacity, keeping its word
+// and its children, and points `slot` at the new block. `label` may point into the old block.
+static void rebuildNode(RadixTrie *trie, NodeRef &slot, std::string_view label, size_t capacity)
+{
+    NodeRef newRef = newNode(trie, label, capacity);
+    RadixNode *oldNode = nodeAt(trie, slot);
+    RadixNode *node = nodeAt(trie, newRef);
+    node->isEndOfWord = oldNode->isEndOfWord;
+    node->numChildren = oldNode->numChildren;
+    node->wordCount = oldNode->wordCount;
+    node->meaningOffset = oldNode->meaningOffset;
+    node->meaningLength = oldNode->meaningLength;
+    std::memcpy(childRefs(node), childRefs(oldNode), oldNode->numChildren * sizeof(NodeRef));
+    std::memcpy(childKeys(node), childKeys(oldNode), oldNode->numChildren);
+
+    freeNode(trie, slot);
+    slot = newRef;
+}
+
+// Returns the slot of the child whose label starts with the given letter, or nullptr if there is none.
+static NodeRef *findSlot(RadixNode *node, char letter)
+{
+    uint8_t key = uint8_t(letter - 'a');
+    const uint8_t *keys = childKeys(node);
+#if defined(__SSE2__)
+    if (node->capacity >= 16)
+    {
+        // Wide nodes (the first letters of most words) compare 16 keys at a time. With 26 slots the
+        // second load overlaps the first, so neither reads past the key bytes.
+        __m128i needle = _mm_set1_epi8(char(key));
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys)), needle)));
+        if (node->capacity > 16)
+        {
+            unsigned high = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + node->capacity - 16)), needle)));
+            mask |= high << (node->capacity - 16);
+        }
+        mask &= (1u << node->numChildren) - 1;
+        return mask != 0 ? &childRefs(node)[__builtin_ctz(mask)] : nullptr;
+    }
+#endif
+    for (int i = 0; i < node->numChildren && keys[i] <= key; i++)
+    {
+        if (keys[i] == key)
+            return &childRefs(node)[i];
+    }
+    return nullptr;
+}
+
+// Adds a child to the node in `slot`, first moving the node to a larger block if it has no free slot.
+static void addChild(RadixTrie *trie, NodeRef &slot, NodeRef child)
+{
+    RadixNode *node = nodeAt(trie, slot);
+    if (node->numChildren == node->capacity)
+    {
+        size_t capacity = node->capacity == 0 ? 2 : node->capacity * 2;
+        rebuildNode(trie, slot, nodeLabel(node), capacity < size_t(ALPHABET_SIZE) ? capacity : ALPHABET_SIZE);
+        node = nodeAt(trie, slot);
+    }
+
+    uint8_t key = uint8_t(nodeLabel(nodeAt(trie, child))[0] - 'a');
+    NodeRef *refs = childRefs(node);
+    uint8_t *keys = childKeys(node);
+    int pos = node->numChildren;
+    while (pos > 0 && keys[pos - 1] > key)
+    {
+        keys[pos] = keys[pos - 1];
+        refs[pos] = refs[pos - 1];
+        pos--;
+    }
+    keys[pos] = key;
+    refs[pos] = child;
+    node->numChildren++;
+}
+
+// Drops the child that starts with the given letter from the node in `slot`, shrinking the block
+// once it is at most a quarter full.
+static void removeChild(RadixTrie *trie, NodeRef &slot, char letter)
+{
+    RadixNode *node = nodeAt(trie, slot);
+    NodeRef *refs = childRefs(node);
+    uint8_t *keys = childKeys(node);
+    int pos = int(findSlot(node, letter) - refs);
+    for (; pos + 1 < node->numChildren; pos++)
+    {
+        keys[pos] = keys[pos + 1];
+        refs[pos] = refs[pos + 1];
+    }
+    node->numChildren--;
+
+    if (node->numChildren * 4 <= node->capacity)
+        rebuildNode(trie, slot, nodeLabel(node), node->capacity / 2);
+}
+
+// Returns how many leading characters the label shares with `key` starting at `pos`.
+static size_t commonLength(std::string_view label, const std::string &key, size_t pos)
+{
+    size_t common = 0;
+    while (common < label.size() && pos + common < key.size() && label[common] == key[pos + common])
+        common++;
+    return common;
+}
+
+// Inserts a word with its meaning into the trie.
+void insert(RadixTrie *trie, const std::string &word, const std::string &meaning)
+{
+    trie->version++;
+    std::string key = wordKey(word);
+    NodeRef *slot = &trie->root; // Handle of the current node, held by its parent (or the trie for the root)
+    size_t pos = 0;
+    while (pos < key.size())
+    {
+        NodeRef *next = findSlot(nodeAt(trie, *slot), key[pos]);
+        if (next == nullptr)
+        {
+            // No edge starts with this letter: hang the rest of the word off the node as a single leaf.
+            size_t length = key.size() - pos < MAX_LABEL_LENGTH ? key.size() - pos : MAX_LABEL_LENGTH;
+            NodeRef leaf = newNode(trie, std::string_view(key).substr(pos, length), 0);
+            addChild(trie, *slot, leaf);
+            next = findSlot(nodeAt(trie, *slot), key[pos]);
+        }
+
+        RadixNode *child = nodeAt(trie, *next);
+        std::string_view label = nodeLabel(child);
+        size_t common = commonLength(label, key, pos);
+        if (common < label.size())
+        {
+            // The word leaves (or ends inside) the edge: split it into a node for the shared part
+            // and the old child with the rest of its label below it.
+            NodeRef middle = newNode(trie, label.substr(0, common), 2);
+            nodeAt(trie, middle)->wordCount = child->wordCount;
+            rebuildNode(trie, *next, label.substr(common), child->capacity);
+            addChild(trie, middle, *next);
+            *next = middle;
+        }
+        slot = next;
+        pos += common;
+    }
+    RadixNode *pCrawl = nodeAt(trie, *slot);
+
+    // A new word bumps the subtree count of every node on its path; replacing a meaning does not.
+    if (!pCrawl->isEndOfWord)
+    {
+        RadixNode *pCount = nodeAt(trie, trie->root);
+        pCount->wordCount++;
+        for (size_t i = 0; i < key.size(); i += pCount->labelLength)
+        {
+            pCount = nodeAt(trie, *findSlot(pCount, key[i]));
+            pCount->wordCount++;
+        }
+    }
+
+    // Store the word's meaning in the pool. A replaced meaning stays in the append-only pool.
+    pCrawl->isEndOfWord = true;
+    pCrawl->meaningOffset = trie->meanings.append(meaning);
+    pCrawl->meaningLength = uint32_t(meaning.size());
+}
+
+// Walks the trie along a normalized key. Returns the node whose path covers the key, or nullptr if
+// no stored word starts with it. `extra` receives the part of that node's label past the key's
+// end, which is empty exactly when the key ends on the node itself.
+static RadixNode *findNode(const RadixTrie *trie, const std::string &key, std::string_view &extra)
+{
+    RadixNode *node = nodeAt(trie, trie->root);
+    extra = std::string_view();
+    size_t pos = 0;
+    while (pos < key.size())
+    {
+        NodeRef *next = findSlot(node, key[pos]);
+        if (next == nullptr)
+            return nullptr;
+        node = nodeAt(trie, *next);
+        std::string_view label = nodeLabel(node);
+        size_t common = commonLength(label, key, pos);
+        if (common < label.size())
+        {
+            if (pos + common < key.size())
+                return nullptr; // The key leaves the edge
+            extra = label.substr(common);
+            return node;
+        }
+        pos += common;
+    }
+    return node;
+}
+
+// Returns the node a word ends on, or nullptr if the word is not stored.
+static RadixNode *findWord(const RadixTrie *trie, const std::string &word)
+{
+    std::string_view extra;
+    RadixNode *node = findNode(trie, wordKey(word), extra);
+    return (node != nullptr && extra.empty() && node->isEndOfWord) ? node : nullptr;
+}
+
+// Searches for a word in the trie and returns true if found.
+bool search(const RadixTrie *trie, const std::string &word)
+{
+    return findWord(trie, word) != nullptr;
+}
+
+// Retrieves the meaning of a word if found in the trie, otherwise returns an empty view.
+std::string_view getMeaning(const RadixTrie *trie, const std::string &word)
+{
+    RadixNode *node = findWord(trie, word);
+    return node != nullptr ? trie->meanings.get(node->meaningOffset, node->meaningLength) : std::string_view();
+}
+
+// Depth-first walk below a node. `word` already ends with the node's label and is extended in place
+// by each child's label. Collects (word, meaning) pairs when `meanings` is set and words otherwise;
+// whole subtrees that lie before `offset` are skipped using their word counts.
+static void collect(const RadixTrie *trie, RadixNode *node, std::string &word, size_t &offset, size_t limit,
+                    std::vector<std::string> *words, std::vector<std::pair<std::string, std::string>> *meanings)
+{
+    auto found = [&]() { return words != nullptr ? words->size() : meanings->size(); };
+    if (node->isEndOfWord)
+    {
+        if (offset > 0)
+            offset--; // Still skipping towards the requested offset
+        else if (words != nullptr)
+            words->push_back(word);
+        else
+            meanings->push_back({word, std::string(trie->meanings.get(node->meaningOffset, node->meaningLength))});
+    }
+    for (int i = 0; i < node->numChildren && found() < limit; i++)
+    {
+        RadixNode *child = nodeAt(trie, childRefs(node)[i]);
+        if (offset >= child->wordCount)
+        {
+            offset -= child->wordCount; // The whole subtree lies before the offset
+            continue;
+        }
+        size_t length = word.size();
+        word.append(nodeLabel(child));
+        collect(trie, child, word, offset, limit, words, meanings);
+        word.resize(length);
+    }
+}
+
+// Returns a list of words with their meanings based on the provided prefix.
+std::vector<std::pair<std::string, std::string>> getSuggestions(const RadixTrie *trie, const std::string &prefix)
+{
+    std::vector<std::pair<std::string, std::string>> suggestions;
+    std::string_view extra;
+    RadixNode *node = findNode(trie, wordKey(prefix), extra);
+    if (node == nullptr)
+        return suggestions; // Return empty vector if no words match the prefix
+
+    std::string word = prefix;
+    word.append(extra); // The prefix may end inside the node's label
+    size_t offset = 0;
+    collect(trie, node, word, offset, size_t(-1), nullptr, &suggestions);
+    return suggestions;
+}
+
+// Returns up to `limit` words that share the given prefix, stopping as soon as enough are found.
+std::vector<std::string> getCompletions(const RadixTrie *trie, const std::string &prefix, size_t limit, size_t offset)
+{
+    std::vector<std::string> completions;
+    std::string_view extra;
+    RadixNode *node = findNode(trie, wordKey(prefix), extra);
+    if (node == nullptr || limit == 0 || offset >= node->wordCount)
+        return completions;
+
+    std::string word = prefix;
+    word.append(extra);
+    collect(trie, node, word, offset, limit, &completions, nullptr);
+    return completions;
+}
+
+// Returns the number of words that share the given prefix.
+size_t countWords(const RadixTrie *trie, const std::string &prefix)
+{
+    std::string_view extra;
+    RadixNode *node = findNode(trie, wordKey(prefix), extra);
+    return node != nullptr ? node->wordCount : 0;
+}
+
+// Merges a node that no longer ends a word and has a single child with that child: the child's
+// label is appended to the node's label and the combined node takes the child's place in `slot`.
+// Labels that would get longer than MAX_LABEL_LENGTH are left as they are.
+static void mergeWithChild(RadixTrie *trie, NodeRef &slot)
+{
+    RadixNode *node = nodeAt(trie, slot);
+    NodeRef childRef = childRefs(node)[0];
+    RadixNode *child = nodeAt(trie, childRef);
+    if (size_t(node->labelLength) + child->labelLength > MAX_LABEL_LENGTH)
+        return;
+
+    std::string label(nodeLabel(node));
+    label.append(nodeLabel(child));
+    rebuildNode(trie, childRef, label, child->capacity);
+    freeNode(trie, slot);
+    slot = childRef;
+}
+
+// Recursive helper for remove(). `slot` holds the handle of the current node and `pos` is where its
+// label ends in the key. Sets `removed` when the word was present.
+static void removeHelper(RadixTrie *trie, NodeRef &slot, const std::string &key, size_t pos, bool &removed)
+{
+    RadixNode *node = nodeAt(trie, slot);
+    if (pos == key.size())
+    {
+        if (node->isEndOfWord)
+        {
+            node->isEndOfWord = false;
+            node->meaningLength = 0;
+            node->wordCount--;
+            removed = true;
+        }
+        return;
+    }
+
+    NodeRef *next = findSlot(node, key[pos]);
+    if (next == nullptr)
+        return; // The word is not in the trie
+    std::string_view label = nodeLabel(nodeAt(trie, *next));
+    if (commonLength(label, key, pos) < label.size())
+        return; // The word leaves or ends inside the edge
+
+    removeHelper(trie, *next, key, pos + label.size(), removed);
+    if (!removed)
+        return;
+    node->wordCount--;
+
+    // Free a child that no longer holds or leads to a word, and collapse one left with a single child.
+    RadixNode *child = nodeAt(trie, *next);
+    if (!child->isEndOfWord && child->numChildren == 0)
+    {
+        freeNode(trie, *next);
+        removeChild(trie, slot, key[pos]); // May move the node to a smaller block
+    }
+    else if (!child->isEndOfWord && child->numChildren == 1)
+    {
+        mergeWithChild(trie, *next);
+    }
+}
+
+// Removes a word from the trie.
+bool remove(RadixTrie *trie, const std::string &word)
+{
+    trie->version++;
+    bool removed = false;
+    removeHelper(trie, trie->root, wordKey(word), 0, removed);
+    return removed;
+}
+
+// Reports the node and meaning memory of the trie.
+TrieMemoryUsage getMemoryUsage(const RadixTrie *trie)
+{
+    TrieMemoryUsage usage;
+    usage.nodeCount = trie->nodeCount;
+    usage.nodeBytesUsed = trie->nodes.bytesUsed();
+    usage.nodeBytesReserved = trie->nodes.bytesReserved();
+    usage.meaningBytesUsed = trie->meanings.bytesUsed();
+    usage.meaningBytesReserved = trie->meanings.bytesReserved();
+    return usage;
+}
+
+// Deletes the entire trie, releasing the arena and the pool in one step each.
+void deleteTrie(RadixTrie *&trie)
+{
+    if (!trie)
+        return;
+    trie->nodes.release();
+    trie->meanings.release();
+    delete trie;
+    trie = nullptr;
+}
@@ -0,0 +1,86 @@
+#ifndef RADIX_TRIE_H
+#define RADIX_TRIE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "NodeArena.h"
+#include "MeaningPool.h"
+#include "Trie.h"
+
+// Path-compressed (radix) variant of the dictionary trie. A chain of single-child nodes that do not
+// end a word is collapsed into one node whose edge label holds all of its letters, so a lookup
+// follows one handle per branching point instead of one per character. Keys are normalized the
+// same way Trie does it: non-letters are skipped and letters are lowercased.
+//
+// A node is a variable-sized arena block: this header, then `capacity` child handles, then
+// `capacity` key bytes (the first letter of each child's label, ascending), then the label itself.
+struct RadixNode {
+    bool isEndOfWord;
+    uint8_t numChildren;
+    uint8_t capacity;         // Child slots in the block
+    uint8_t labelLength;      // Letters on the edge leading into this node (0 only for the root)
+    unsigned int wordCount;   // Number of words stored in this node's subtree, including the node itself
+    uint32_t meaningOffset;   // Location of the word's meaning in the trie's meaning pool
+    uint32_t meaningLength;
+};
+
+const size_t MAX_LABEL_LENGTH = 255; // Longer chains are split across several nodes
+
+struct RadixTrie {
+    NodeRef root = NO_NODE;
+    NodeArena nodes;
+    MeaningPool meanings;
+    size_t nodeCount = 0;      // Live nodes, including the root
+    unsigned long version = 0; // Bumped by every modification
+};
+
+// Creates an empty path-compressed trie.
+RadixTrie *createRadixTrie();
+
+// Translates a node handle into the node.
+inline RadixNode *nodeAt(const RadixTrie *trie, NodeRef ref)
+{
+    return static_cast<RadixNode *>(trie->nodes.pointer(ref));
+}
+
+// Returns the edge label of a node (lowercase letters).
+inline std::string_view nodeLabel(const RadixNode *node)
+{
+    const char *label = reinterpret_cast<const char *>(node + 1) + node->capacity * (sizeof(NodeRef) + 1);
+    return std::string_view(label, node->labelLength);
+}
+
+// The operations below behave exactly like their Trie counterparts in Trie.h.
+
+// Inserts a word and its meaning, splitting an edge where the word leaves an existing label.
+void insert(RadixTrie *trie, const std::string &word, const std::string &meaning);
+
+// Checks if a word exists in the trie.
+bool search(const RadixTrie *trie, const std::string &word);
+
+// Returns the meaning of the word if it exists; otherwise, returns an empty view into the meaning pool.
+std::string_view getMeaning(const RadixTrie *trie, const std::string &word);
+
+// Returns a vector of (word, meaning) suggestions that share the given prefix.
+std::vector<std::pair<std::string, std::string>> getSuggestions(const RadixTrie *trie, const std::string &prefix);
+
+// Returns up to `limit` words that share the given prefix, in alphabetical order,
+// skipping the first `offset` matches. Meanings are not copied.
+std::vector<std::string> getCompletions(const RadixTrie *trie, const std::string &prefix, size_t limit, size_t offset = 0);
+
+// Returns the number of words that share the given prefix, without walking the subtree.
+size_t countWords(const RadixTrie *trie, const std::string &prefix);
+
+// Removes a word, freeing nodes only it used and merging a node left with a single child into
+// that child. Returns true if the word was present.
+bool remove(RadixTrie *trie, const std::string &word);
+
+// Reports how much memory the trie's nodes and meanings use and reserve.
+TrieMemoryUsage getMemoryUsage(const RadixTrie *trie);
+
+// Deletes the whole trie by releasing its arena and meaning pool in one step each.
+void deleteTrie(RadixTrie *&trie);
+
+#endif // RADIX_TRIE_H
@@ -0,0 +1,57 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Fixed-size ring buffer for exactly one producer thread and one consumer thread, with no locks:
+// the producer only writes writeIndex and the consumer only writes readIndex, each published
+// with a release store and read with an acquire load, so a slot is never read before it is
+// filled or refilled before it is read. The two indices sit on separate cache lines so the
+// threads do not bounce one line between them. One slot stays empty to tell full from empty.
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+public:
+    SpscQueue() = default;
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer only. Returns false, leaving the item untouched, if the queue is full.
+    bool push(T &item)
+    {
+        size_t write = writeIndex.load(std::memory_order_relaxed);
+        size_t next = (write + 1) % CAPACITY;
+        if (next == readIndex.load(std::memory_order_acquire))
+            return false;
+        slots[write] = std::move(item);
+        writeIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the queue is empty.
+    bool pop(T &item)
+    {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        if (read == writeIndex.load(std::memory_order_acquire))
+            return false;
+        item = std::move(slots[read]);
+        readIndex.store((read + 1) % CAPACITY, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; from the producer the answer may already be stale.
+    bool empty() const
+    {
+        return readIndex.load(std::memory_order_relaxed) == writeIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    T slots[CAPACITY];
+    alignas(64) std::atomic<size_t> readIndex{0};
+    alignas(64) std::atomic<size_t> writeIndex{0};
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,219 @@
+#include "SuggestionRanker.h"
+#include "DictionaryParser.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Higher score first; alphabetical among equal scores, like the unranked completions.
+bool SuggestionRanker::better(const Entry &a, const Entry &b) const
+{
+    if (a.score != b.score)
+        return a.score > b.score;
+    return words[a.word] < words[b.word];
+}
+
+// A higher score can only move the word into lists or up in them. The prefixes are visited from
+// the longest: a word that does not make a prefix's list cannot make a shorter prefix's either,
+// since that list draws from more words.
+void SuggestionRanker::raise(const std::string &key, uint32_t id, uint32_t score)
+{
+    auto order = [this](const Entry &a, const Entry &b) { return better(a, b); };
+    for (size_t length = key.size() + 1; length-- > 0;)
+    {
+        std::vector<Entry> &list = top[key.substr(0, length)];
+        auto found = std::find_if(list.begin(), list.end(), [id](const Entry &entry) { return entry.word == id; });
+        Entry entry{score, id};
+        if (found != list.end())
+            found->score = score;
+        else if (list.size() < TOP_K || better(entry, list.back()))
+            list.push_back(entry);
+        else
+            break;
+        std::sort(list.begin(), list.end(), order);
+        if (list.size() > TOP_K)
+            list.pop_back();
+    }
+}
+
+// A lower score (or 0, for removal) can let a word that was not listed into a full list, so a full
+// list holding the word is rebuilt from its children's lists, which are already up to date since
+// the prefixes are visited from the longest. A list that is not full holds every scored word below
+// its prefix and only needs the word's own entry changed.
+void SuggestionRanker::lower(const std::string &key, uint32_t id, uint32_t score)
+{
+    auto order = [this](const Entry &a, const Entry &b) { return better(a, b); };
+    for (size_t length = key.size() + 1; length-- > 0;)
+    {
+        std::string prefix = key.substr(0, length);
+        auto list = top.find(prefix);
+        if (list == top.end())
+            break;
+        auto found = std::find_if(list->second.begin(), list->second.end(), [id](const Entry &entry) { return entry.word == id; });
+        if (found == list->second.end())
+            break; // Not listed here, so not in any shorter prefix's list either
+        if (list->second.size() == TOP_K)
+        {
+            rebuild(prefix);
+            continue;
+        }
+        if (score == 0)
+            list->second.erase(found);
+        else
+            found->score = score;
+        std::sort(list->second.begin(), list->second.end(), order);
+        if (list->second.empty())
+            top.erase(list);
+    }
+}
+
+// Merges the prefix's own word with the lists of its 26 possible one-letter extensions.
+void SuggestionRanker::rebuild(const std::string &prefix)
+{
+    std::vector<Entry> list;
+    auto own = ids.find(prefix);
+    if (own != ids.end())
+    {
+        auto scored = scores.find(own->second);
+        if (scored != scores.end())
+            list.push_back(Entry{scored->second, own->second});
+    }
+    std::string child = prefix + 'a';
+    for (char letter = 'a'; letter <= 'z'; letter++)
+    {
+        child.back() = letter;
+        auto childList = top.find(child);
+        if (childList != top.end())
+            list.insert(list.end(), childList->second.begin(), childList->second.end());
+    }
+    std::sort(list.begin(), list.end(), [this](const Entry &a, const Entry &b) { return better(a, b); });
+    if (list.size() > TOP_K)
+        list.resize(TOP_K);
+    if (list.empty())
+        top.erase(prefix);
+    else
+        top[prefix] = std::move(list);
+}
+
+void SuggestionRanker::setScore(std::string_view word, uint32_t score)
+{
+    std::string key = wordKey(word);
+    auto known = ids.find(key);
+    if (known == ids.end())
+    {
+        if (score == 0)
+            return;
+        known = ids.emplace(key, uint32_t(words.size())).first;
+        words.push_back(key);
+    }
+    uint32_t id = known->second;
+    uint32_t old = 0;
+    auto scored = scores.find(id);
+    if (scored != scores.end())
+        old = scored->second;
+    if (score == old)
+        return;
+
+    if (score == 0)
+        scores.erase(id);
+    else
+        scores[id] = score;
+    if (score > old)
+        raise(key, id, score);
+    else
+        lower(key, id, score);
+}
+
+void SuggestionRanker::addScore(std::string_view word, uint32_t amount)
+{
+    uint32_t current = score(word);
+    setScore(word, current > UINT32_MAX - amount ? UINT32_MAX : current + amount);
+}
+
+uint32_t SuggestionRanker::score(std::string_view word) const
+{
+    auto known = ids.find(wordKey(word));
+    if (known == ids.end())
+        return 0;
+    auto scored = scores.find(known->second);
+    return scored != scores.end() ? scored->second : 0;
+}
+
+std::vector<std::string> SuggestionRanker::topCompletions(std::string_view prefix) const
+{
+    std::vector<std::string> completions;
+    auto list = top.find(wordKey(prefix));
+    if (list == top.end())
+        return completions;
+    for (const Entry &entry : list->second)
+        completions.push_back(words[entry.word]);
+    return completions;
+}
+
+// The count is the first number after the word; the word ends at a space, tab or comma.
+bool loadWordFrequencies(SuggestionRanker &ranker, const Trie *trie, const std::string &filename)
+{
+    LineReader reader(filename);
+    if (!reader.isOpen())
+        return false;
+
+    std::string_view line;
+    std::string word;
+    while (reader.next(line))
+    {
+        size_t end = line.find_first_of(" \t,");
+        if (end == std::string_view::npos)
+            continue;
+        word.assign(line.substr(0, end));
+        std::string count(line.substr(end + 1));
+        unsigned long frequency = std::strtoul(count.c_str(), nullptr, 10);
+        if (frequency > 0 && search(trie, word))
+            ranker.setScore(word, frequency > UINT32_MAX ? UINT32_MAX : uint32_t(frequency));
+    }
+    return true;
+}
+
+// The ranked words come from the ranker's list for the prefix. Their alphabetical ranks tell where
+// a row of the alphabetical part starts: row j is the j-th completion that is not ranked, so the
+// iterator is moved past one more rank for every ranked word at or before it, and skips them
+// as it goes.
+std::vector<std::string> getRankedCompletions(const PrefixCursor &cursor, const SuggestionRanker &ranker, CompletionIterator &iterator,
+                                              size_t limit, size_t offset)
+{
+    std::vector<std::string> ranked;
+    std::vector<size_t> rankedRanks; // Alphabetical ranks of the ranked words, ascending
+    for (std::string &word : ranker.topCompletions(cursor.prefix))
+    {
+        size_t rank;
+        if (completionRank(cursor, word, rank))
+        {
+            ranked.push_back(std::move(word));
+            rankedRanks.push_back(rank);
+        }
+    }
+    std::sort(rankedRanks.begin(), rankedRanks.end());
+
+    std::vector<std::string> completions;
+    for (size_t row = offset; row < ranked.size() && completions.size() < limit; row++)
+        completions.push_back(ranked[row]);
+    if (completions.size() >= limit)
+        return completions;
+
+    size_t rank = offset > ranked.size() ? offset - ranked.size() : 0;
+    for (size_t skipped : rankedRanks)
+    {
+        if (skipped <= rank)
+            rank++;
+    }
+    completionSeek(iterator, cursor, rank);
+    for (; completionValid(iterator) && completions.size() < limit; completionNext(iterator))
+    {
+        if (!std::binary_search(rankedRanks.begin(), rankedRanks.end(), iterator.rank))
+            completions.push_back(iterator.word);
+    }
+    return completions;
+}
+
+std::vector<std::string> getRankedCompletions(const PrefixCursor &cursor, const SuggestionRanker &ranker, size_t limit)
+{
+    CompletionIterator iterator;
+    return getRankedCompletions(cursor, ranker, iterator, limit);
+}
@@ -0,0 +1,74 @@
+#ifndef SUGGESTION_RANKER_H
+#define SUGGESTION_RANKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Trie.h"
+
+// Scores words by how often they are used and keeps, for every prefix of a scored word, its
+// TOP_K best-scoring completions. Ranked suggestions for a prefix are then one lookup instead of a
+// subtree walk and a sort. Words without a score (most of the dictionary) are not stored at all;
+// they follow the ranked ones in alphabetical order. Words and prefixes are kept by their
+// letters, lowercased, as the Trie stores them.
+class SuggestionRanker
+{
+public:
+    static constexpr size_t TOP_K = 8;
+    // What one lookup adds to a word's score: about the count of a very common word in a
+    // frequency list, so words the user looks up rise to the top of their prefixes.
+    static constexpr uint32_t LOOKUP_SCORE = 1000000;
+
+    // Sets a word's score; a score of 0 removes it.
+    void setScore(std::string_view word, uint32_t score);
+
+    // Adds to a word's score, e.g. LOOKUP_SCORE when it is looked up.
+    void addScore(std::string_view word, uint32_t amount);
+
+    uint32_t score(std::string_view word) const;
+
+    // Forgets a word's score, e.g. when it is removed from the dictionary.
+    void remove(std::string_view word) { setScore(word, 0); }
+
+    // Returns the best-scoring words that start with the prefix, best first and alphabetical
+    // among equal scores; at most TOP_K of them.
+    std::vector<std::string> topCompletions(std::string_view prefix) const;
+
+    size_t scoredWords() const { return scores.size(); }
+
+private:
+    struct Entry {
+        uint32_t score;
+        uint32_t word; // Index into `words`
+    };
+
+    bool better(const Entry &a, const Entry &b) const;
+    void raise(const std::string &key, uint32_t id, uint32_t score);
+    void lower(const std::string &key, uint32_t id, uint32_t score);
+    void rebuild(const std::string &prefix);
+
+    std::vector<std::string> words;                        // Every word ever scored, by id
+    std::unordered_map<std::string, uint32_t> ids;         // Id of each word in `words`
+    std::unordered_map<uint32_t, uint32_t> scores;         // Score of each scored word, by id
+    std::unordered_map<std::string, std::vector<Entry>> top; // Best entries per prefix, sorted
+};
+
+// Reads a frequency file of "word count" lines and scores each word that is in the dictionary with
+// its count. Returns false if the file cannot be opened.
+bool loadWordFrequencies(SuggestionRanker &ranker, const Trie *trie, const std::string &filename);
+
+// Returns up to `limit` completions of the cursor's prefix: the ranked ones first, then the
+// remaining words in alphabetical order.
+std::vector<std::string> getRankedCompletions(const PrefixCursor &cursor, const SuggestionRanker &ranker, size_t limit);
+
+// Returns up to `limit` rows of the same list, starting at row `offset` and continuing with every
+// remaining completion, so that the list can be scrolled through all of them. The iterator is left
+// after the last row returned; passing it back for the next rows resumes from there instead of
+// walking the completions again.
+std::vector<std::string> getRankedCompletions(const PrefixCursor &cursor, const SuggestionRanker &ranker, CompletionIterator &iterator,
+                                              size_t limit, size_t offset = 0);
+
+#endif // SUGGESTION_RANKER_H
@@ -1,162 +1,1356 @@
 #include "Trie.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-// Creates a new Trie node with initialized properties (children set to nullptr).
-TrieNode *getNode()
+std::string wordKey(std::string_view word)
 {
-    TrieNode *node = new TrieNode;
+    std::string key;
+    key.reserve(word.size());
+    for (char ch : word)
+    {
+        int index = letterIndex(ch);
+        if (index >= 0)
+            key.push_back(char('a' + index));
+    }
+    return key;
+}
+
+// Creates an empty Trie with just a root node.
+Trie *createTrie()
+{
+    Trie *trie = new Trie;
+    trie->root = getNode(trie);
+    return trie;
+}
+
+// Returns the number of bytes a node of the given layout takes in the arena.
+static size_t nodeSize(uint8_t type)
+{
+    switch (type)
+    {
+    case NODE_4:
+        return sizeof(TrieNode4);
+    case NODE_16:
+        return sizeof(TrieNode16);
+    case NODE_FULL:
+        return sizeof(TrieNodeFull);
+    default:
+        return sizeof(TrieNode);
+    }
+}
+
+// Creates a new Trie node of the given layout in the trie's arena with initialized properties (no children).
+NodeRef getNode(Trie *trie, NodeType type)
+{
+    NodeRef ref = trie->nodes.allocate(nodeSize(type));
+    TrieNode *node = nodeAt(trie, ref);
+    trie->nodeCount++;
+    node->type = type;
+    node->numChildren = 0;
     node->isEndOfWord = false; // Word termination flag
-    node->meaning = "";        // Meaning of the word (empty by default)
-    for (int i = 0; i < ALPHABET_SIZE; i++)
+    node->partsOfSpeech = 0;
+    node->wordCount = 0;       // No words below a fresh node
+    node->meaningOffset = 0;   // Meaning of the word (empty by default)
+    node->meaningLength = 0;
+    if (type == NODE_FULL)
     {
-        node->children[i] = nullptr; // Initialize all child pointers to nullptr
+        TrieNodeFull *full = static_cast<TrieNodeFull *>(node);
+        for (int i = 0; i < ALPHABET_SIZE; i++)
+        {
+            full->children[i] = NO_NODE; // Initialize all child handles to "no node"
+        }
     }
-    return node;
+    return ref;
 }
 
-// Inserts a word with its meaning into the Trie.
-void insert(TrieNode *root, const std::string &word, const std::string &meaning)
+// Gives a node back to the trie's arena so that its slot can be reused.
+static void freeNode(Trie *trie, NodeRef ref)
 {
-    TrieNode *pCrawl = root;
+    trie->nodes.deallocate(ref, nodeSize(nodeAt(trie, ref)->type));
+    trie->nodeCount--;
+}
+
+// Returns the slot holding a node's child for a letter index, or nullptr if there is no such child.
+static NodeRef *findSlot(TrieNode *node, int index)
+{
+    switch (node->type)
+    {
+    case NODE_4:
+    {
+        TrieNode4 *n = static_cast<TrieNode4 *>(node);
+        for (int i = 0; i < n->numChildren && n->keys[i] <= index; i++)
+        {
+            if (n->keys[i] == index)
+                return &n->children[i];
+        }
+        return nullptr;
+    }
+    case NODE_16:
+    {
+        TrieNode16 *n = static_cast<TrieNode16 *>(node);
+#if defined(__SSE2__)
+        // Compare all 16 keys at once; bits past numChildren belong to unused key bytes.
+        __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i *>(n->keys));
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(keys, _mm_set1_epi8(char(index)))));
+        mask &= (1u << n->numChildren) - 1;
+        return mask != 0 ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+        for (int i = 0; i < n->numChildren && n->keys[i] <= index; i++)
+        {
+            if (n->keys[i] == index)
+                return &n->children[i];
+        }
+        return nullptr;
+#endif
+    }
+    case NODE_FULL:
+    {
+        TrieNodeFull *n = static_cast<TrieNodeFull *>(node);
+        return n->children[index] != NO_NODE ? &n->children[index] : nullptr;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+// Returns the child of a node for a letter index, or nullptr if there is none.
+TrieNode *findChild(const Trie *trie, const TrieNode *node, int index)
+{
+    NodeRef *slot = findSlot(const_cast<TrieNode *>(node), index);
+    return slot != nullptr ? nodeAt(trie, *slot) : nullptr;
+}
+
+// Copies a node's children, in alphabetical order, into `keys` and `refs`. Returns how many there are.
+static int copyChildren(const TrieNode *node, uint8_t *keys, NodeRef *refs)
+{
+    int count = 0;
+    switch (node->type)
+    {
+    case NODE_4:
+    case NODE_16:
+    {
+        const uint8_t *nodeKeys = node->type == NODE_4 ? static_cast<const TrieNode4 *>(node)->keys : static_cast<const TrieNode16 *>(node)->keys;
+        const NodeRef *nodeRefs = node->type == NODE_4 ? static_cast<const TrieNode4 *>(node)->children : static_cast<const TrieNode16 *>(node)->children;
+        for (; count < node->numChildren; count++)
+        {
+            keys[count] = nodeKeys[count];
+            refs[count] = nodeRefs[count];
+        }
+        break;
+    }
+    case NODE_FULL:
+    {
+        const TrieNodeFull *n = static_cast<const TrieNodeFull *>(node);
+        for (int i = 0; i < ALPHABET_SIZE; i++)
+        {
+            if (n->children[i] != NO_NODE)
+            {
+                keys[count] = uint8_t(i);
+                refs[count++] = n->children[i];
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return count;
+}
+
+// Moves the node in `slot` to a new node of another layout, keeping its word and its children,
+// and points `slot` at the new node.
+static void changeLayout(Trie *trie, NodeRef &slot, NodeType type)
+{
+    NodeRef newRef = getNode(trie, type);
+    TrieNode *oldNode = nodeAt(trie, slot);
+    TrieNode *newNode = nodeAt(trie, newRef);
+    newNode->isEndOfWord = oldNode->isEndOfWord;
+    newNode->partsOfSpeech = oldNode->partsOfSpeech;
+    newNode->wordCount = oldNode->wordCount;
+    newNode->meaningOffset = oldNode->meaningOffset;
+    newNode->meaningLength = oldNode->meaningLength;
+
+    uint8_t keys[ALPHABET_SIZE];
+    NodeRef refs[ALPHABET_SIZE];
+    int count = copyChildren(oldNode, keys, refs);
+    for (int i = 0; i < count; i++)
+    {
+        if (type == NODE_4)
+        {
+            static_cast<TrieNode4 *>(newNode)->keys[i] = keys[i];
+            static_cast<TrieNode4 *>(newNode)->children[i] = refs[i];
+        }
+        else if (type == NODE_16)
+        {
+            static_cast<TrieNode16 *>(newNode)->keys[i] = keys[i];
+            static_cast<TrieNode16 *>(newNode)->children[i] = refs[i];
+        }
+        else
+        {
+            static_cast<TrieNodeFull *>(newNode)->children[keys[i]] = refs[i];
+        }
+    }
+    newNode->numChildren = uint8_t(count);
+
+    freeNode(trie, slot);
+    slot = newRef;
+}
+
+// Inserts a key into a sorted key array, shifting the larger keys (and their children) up by one.
+static void insertSorted(uint8_t *keys, NodeRef *children, int count, int index, NodeRef child)
+{
+    int pos = count;
+    while (pos > 0 && keys[pos - 1] > index)
+    {
+        keys[pos] = keys[pos - 1];
+        children[pos] = children[pos - 1];
+        pos--;
+    }
+    keys[pos] = uint8_t(index);
+    children[pos] = child;
+}
+
+// Removes a key from a sorted key array, shifting the larger keys (and their children) down by one.
+static void eraseSorted(uint8_t *keys, NodeRef *children, int count, int index)
+{
+    int pos = 0;
+    while (pos < count && keys[pos] != index)
+        pos++;
+    for (; pos + 1 < count; pos++)
+    {
+        keys[pos] = keys[pos + 1];
+        children[pos] = children[pos + 1];
+    }
+}
+
+// Adds a child to the node in `slot`, first growing the node to the next layout if it is full.
+static void addChild(Trie *trie, NodeRef &slot, int index, NodeRef child)
+{
+    TrieNode *node = nodeAt(trie, slot);
+    if (node->type == NODE_LEAF)
+        changeLayout(trie, slot, NODE_4);
+    else if (node->type == NODE_4 && node->numChildren == 4)
+        changeLayout(trie, slot, NODE_16);
+    else if (node->type == NODE_16 && node->numChildren == 16)
+        changeLayout(trie, slot, NODE_FULL);
+
+    node = nodeAt(trie, slot);
+    if (node->type == NODE_4)
+        insertSorted(static_cast<TrieNode4 *>(node)->keys, static_cast<TrieNode4 *>(node)->children, node->numChildren, index, child);
+    else if (node->type == NODE_16)
+        insertSorted(static_cast<TrieNode16 *>(node)->keys, static_cast<TrieNode16 *>(node)->children, node->numChildren, index, child);
+    else
+        static_cast<TrieNodeFull *>(node)->children[index] = child;
+    node->numChildren++;
+}
+
+// Drops a child from the node in `slot`, then shrinks the node once a smaller layout fits with
+// room to spare, so that alternating inserts and removes do not resize it every time.
+static void removeChild(Trie *trie, NodeRef &slot, int index)
+{
+    TrieNode *node = nodeAt(trie, slot);
+    if (node->type == NODE_4)
+        eraseSorted(static_cast<TrieNode4 *>(node)->keys, static_cast<TrieNode4 *>(node)->children, node->numChildren, index);
+    else if (node->type == NODE_16)
+        eraseSorted(static_cast<TrieNode16 *>(node)->keys, static_cast<TrieNode16 *>(node)->children, node->numChildren, index);
+    else
+        static_cast<TrieNodeFull *>(node)->children[index] = NO_NODE;
+    node->numChildren--;
+
+    if (node->type == NODE_4 && node->numChildren == 0)
+        changeLayout(trie, slot, NODE_LEAF);
+    else if (node->type == NODE_16 && node->numChildren <= 3)
+        changeLayout(trie, slot, NODE_4);
+    else if (node->type == NODE_FULL && node->numChildren <= 12)
+        changeLayout(trie, slot, NODE_16);
+}
+
+// Copies a meaning into the pool, encoded if the trie's meanings are compressed. Returns its
+// offset and sets `length` to the bytes stored.
+static uint32_t storeMeaning(Trie *trie, std::string_view meaning, uint32_t &length)
+{
+    if (!trie->codec.trained())
+    {
+        length = uint32_t(meaning.size());
+        return trie->meanings.append(meaning);
+    }
+    std::string encoded;
+    trie->codec.encode(meaning, encoded);
+    length = uint32_t(encoded.size());
+    return trie->meanings.append(encoded);
+}
+
+// Returns a stored meaning, decoded into `buffer` if it is encoded.
+static std::string_view storedMeaning(const Trie *trie, uint32_t offset, uint32_t length, std::string &buffer)
+{
+    std::string_view stored = trie->meanings.get(offset, length);
+    return trie->codec.trained() ? trie->codec.decode(stored, buffer) : stored;
+}
+
+std::string_view readMeaning(const Trie *trie, const TrieNode *node, std::string &buffer)
+{
+    return storedMeaning(trie, node->meaningOffset, node->meaningLength, buffer);
+}
+
+// Returns the parts of speech of the word ending at a node, or 0 if no word ends there. A leaf's
+// subtree holds only its own word, so its mask answers without reading the meaning.
+static uint8_t wordPartsOfSpeech(const Trie *trie, const TrieNode *node)
+{
+    if (!node->isEndOfWord)
+        return 0;
+    if (node->numChildren == 0)
+        return node->partsOfSpeech;
+    std::string buffer;
+    return parsePartsOfSpeech(readMeaning(trie, node, buffer));
+}
+
+// Recomputes a node's subtree mask from its own word and its children's masks.
+static void updatePartsOfSpeech(const Trie *trie, TrieNode *node)
+{
+    std::string buffer;
+    uint8_t bits = node->isEndOfWord ? parsePartsOfSpeech(readMeaning(trie, node, buffer)) : 0;
+    forEachChild(trie, node, [&](int, TrieNode *child) { bits |= child->partsOfSpeech; });
+    node->partsOfSpeech = bits;
+}
+
+// Walks the Trie along the given key and returns the node it ends on, or nullptr if the path is missing.
+// Non-alphabet characters are skipped, exactly as insert() does.
+static TrieNode *findNode(const Trie *trie, std::string_view key)
+{
+    TrieNode *pCrawl = nodeAt(trie, trie->root);
+    for (char ch : key)
+    {
+        int index = letterIndex(ch);
+        if (index < 0)
+            continue;
+        pCrawl = findChild(trie, pCrawl, index); // Move to the next node
+        if (pCrawl == nullptr)
+            return nullptr; // The path stops before the key ends
+    }
+    return pCrawl;
+}
+
+// Inserts a word with its meaning, already stored in the pool at `meaningOffset`, into the subtrie
+// under `root`, which is updated if the root changes layout.
+static void insertAt(Trie *trie, NodeRef &root, std::string_view word, std::string_view meaning, uint32_t meaningOffset, uint32_t meaningLength)
+{
+    NodeRef *slot = &root; // Handle of the current node, held by its parent (or the caller for the root)
     for (char ch : word)
     {
-        ch = tolower(ch);     // Ensure the character is lowercase
-        int index = ch - 'a'; // Get the index for the current character
-        if (index < 0 || index >= ALPHABET_SIZE)
+        int index = letterIndex(ch); // Get the (case-insensitive) index for the current character
+        if (index < 0)
             continue; // Ignore non-alphabet characters
-        if (pCrawl->children[index] == nullptr)
+        NodeRef *next = findSlot(nodeAt(trie, *slot), index);
+        if (next == nullptr)
         {
-            pCrawl->children[index] = getNode(); // Create a new node if the child doesn't exist
+            // Create a new node if the child doesn't exist. Adding it may move the parent to a larger layout.
+            NodeRef child = getNode(trie);
+            addChild(trie, *slot, index, child);
+            next = findSlot(nodeAt(trie, *slot), index);
         }
-        pCrawl = pCrawl->children[index]; // Move to the next node in the path
+        slot = next; // Move to the next node in the path
     }
+    TrieNode *pCrawl = nodeAt(trie, *slot);
+    uint8_t partsOfSpeech = parsePartsOfSpeech(meaning);
+    bool replaced = pCrawl->isEndOfWord;
+    bool partsChanged = replaced && wordPartsOfSpeech(trie, pCrawl) != partsOfSpeech;
+
+    // Point the node at the word's meaning. A replaced meaning stays in the append-only pool.
     pCrawl->isEndOfWord = true; // Mark the end of the word
-    pCrawl->meaning = meaning;  // Store the word's meaning
+    pCrawl->meaningOffset = meaningOffset;
+    pCrawl->meaningLength = meaningLength;
+
+    // A new word bumps the subtree count of every node on its path and adds its parts of speech to
+    // their masks. Replacing a meaning changes no count, but a different part of speech may clear
+    // bits, so the masks along the path are then recomputed from the bottom up.
+    if (!replaced)
+    {
+        TrieNode *pCount = nodeAt(trie, root);
+        pCount->wordCount++;
+        pCount->partsOfSpeech |= partsOfSpeech;
+        for (char ch : word)
+        {
+            int index = letterIndex(ch);
+            if (index < 0)
+                continue;
+            pCount = findChild(trie, pCount, index);
+            pCount->wordCount++;
+            pCount->partsOfSpeech |= partsOfSpeech;
+        }
+    }
+    else if (partsChanged)
+    {
+        std::vector<TrieNode *> path(1, nodeAt(trie, root));
+        for (char ch : word)
+        {
+            int index = letterIndex(ch);
+            if (index >= 0)
+                path.push_back(findChild(trie, path.back(), index));
+        }
+        for (size_t i = path.size(); i-- > 0;)
+            updatePartsOfSpeech(trie, path[i]);
+    }
+}
+
+// Inserts a word with its meaning into the Trie.
+void insert(Trie *trie, std::string_view word, std::string_view meaning)
+{
+    trie->version++;
+    NodeRef root = trie->root;
+    uint32_t length;
+    uint32_t offset = storeMeaning(trie, meaning, length);
+    insertAt(trie, root, word, meaning, offset, length);
+    if (root != trie->root)
+        trie->root = root;
+}
+
+// Inserts a word whose meaning is already in the pool.
+void insertStored(Trie *trie, std::string_view word, uint32_t meaningOffset, uint32_t meaningLength)
+{
+    trie->version++;
+    NodeRef root = trie->root;
+    std::string buffer;
+    insertAt(trie, root, word, storedMeaning(trie, meaningOffset, meaningLength, buffer), meaningOffset, meaningLength);
+    if (root != trie->root)
+        trie->root = root;
 }
 
 // Searches for a word in the Trie and returns true if found.
-bool search(TrieNode *root, const std::string &word)
+bool search(const Trie *trie, const std::string &word)
 {
-    TrieNode *pCrawl = root;
-    for (char ch : word)
+    TrieNode *pCrawl = findNode(trie, word);
+    return (pCrawl != nullptr && pCrawl->isEndOfWord); // Check if it's the end of the word
+}
+
+// Returns a node's meaning as a view into the meaning pool. The meanings must not be compressed.
+static std::string_view nodeMeaning(const Trie *trie, const TrieNode *node)
+{
+    assert(!trie->codec.trained());
+    return trie->meanings.get(node->meaningOffset, node->meaningLength);
+}
+
+// Retrieves the meaning of a word if found in the Trie, otherwise returns an empty view.
+std::string_view getMeaning(const Trie *trie, const std::string &word)
+{
+    METRICS_SCOPE(METRIC_GET_MEANING);
+    TrieNode *pCrawl = findNode(trie, word);
+    return (pCrawl != nullptr && pCrawl->isEndOfWord) ? nodeMeaning(trie, pCrawl) : std::string_view(); // Return meaning if word is valid
+}
+
+// Looks the word up like getMeaning(), then decodes its meaning if needed.
+std::string_view getMeaning(const Trie *trie, const std::string &word, std::string &buffer)
+{
+    METRICS_SCOPE(METRIC_GET_MEANING);
+    TrieNode *pCrawl = findNode(trie, word);
+    return (pCrawl != nullptr && pCrawl->isEndOfWord) ? readMeaning(trie, pCrawl, buffer) : std::string_view();
+}
+
+// Number of lookups getMeanings() keeps going at once. Each one waits on at most one node that is
+// being fetched, so this many cache misses can be outstanding while the lanes take turns.
+static const size_t LOOKUP_LANES = 8;
+
+// Words getMeanings() sorts and looks up together. Sorting costs more per word as blocks grow,
+// while the prefixes they share save less and less, so large batches are taken a block at a time.
+static const size_t LOOKUP_BLOCK = 1024;
+
+// Characters of a word's path a lane remembers for the next word to start from.
+static const size_t LOOKUP_PATH = 32;
+
+// Below this many words the nodes mostly stay in cache, there are no misses to overlap, and
+// switching between lanes costs more than it saves; getMeanings() then walks each word on its own.
+// (Measured break-even: about 8 MB of nodes, a few tens of thousands of words.)
+static const unsigned LOOKUP_INTERLEAVE_WORDS = 50000;
+
+// One of getMeanings() interleaved lookups. A lane looks up a run of consecutive words of the
+// sorted block, keeping the path of the previous word like a PrefixCursor, so a word starts from
+// the node of the prefix it shares with the word before it.
+struct LookupLane {
+    const uint32_t *next;          // Position in the sorted block of the word being looked up
+    const uint32_t *end;
+    std::string_view word;
+    std::string_view previous;     // Word looked up before `word`, whose path is in `path`
+    size_t depth;                  // Characters of `word` walked so far
+    TrieNode *node;                // Node reached after them, or nullptr once off the Trie
+    TrieNode *path[LOOKUP_PATH];   // path[i] is the node reached after word[i]
+};
+
+// Asks for the cache lines findChild() will read from a node: the header with the keys, and the
+// child handles that follow.
+static inline void prefetchNode(const TrieNode *node)
+{
+    __builtin_prefetch(node);
+    __builtin_prefetch(reinterpret_cast<const char *>(node) + 64);
+}
+
+static inline void startLookup(LookupLane &lane, TrieNode *root, std::string_view word)
+{
+    size_t limit = std::min({lane.previous.size(), word.size(), LOOKUP_PATH});
+    size_t common = 0;
+    while (common < limit && lane.previous[common] == word[common])
+        common++;
+    lane.word = word;
+    lane.depth = common;
+    lane.node = common > 0 ? lane.path[common - 1] : root;
+}
+
+// Moves a lane one edge down its word, or, at the end of the word, stores the meaning and starts
+// the next word. Returns false once the lane has no words left.
+static inline bool stepLookup(const Trie *trie, TrieNode *root, LookupLane &lane, const std::vector<std::string_view> &words,
+                              std::vector<std::string_view> &meanings)
+{
+    TrieNode *node = lane.node;
+    if (lane.depth == lane.word.size())
     {
-        int index = ch - 'a'; // Calculate index for the character
-        if (pCrawl->children[index] == nullptr)
-            return false;                 // If the child doesn't exist, return false
-        pCrawl = pCrawl->children[index]; // Move to the next node
+        if (node != nullptr && node->isEndOfWord)
+        {
+            std::string_view meaning = nodeMeaning(trie, node);
+            __builtin_prefetch(meaning.data()); // The caller is about to read it
+            meanings[*lane.next] = meaning;
+        }
+        lane.previous = lane.word;
+        if (++lane.next == lane.end)
+            return false;
+        startLookup(lane, root, words[*lane.next]);
+        return true;
     }
-    return (pCrawl != nullptr && pCrawl->isEndOfWord); // Check if it's the end of the word
+
+    if (node == nullptr)
+    {
+        // Off the Trie: no later letter can lead back onto it.
+        for (size_t i = lane.depth; i < std::min(lane.word.size(), LOOKUP_PATH); i++)
+            lane.path[i] = nullptr;
+        lane.depth = lane.word.size();
+        return true;
+    }
+    int index = letterIndex(lane.word[lane.depth]);
+    if (index >= 0) // Non-letters keep the lookup where it is, as in insert()
+    {
+        node = findChild(trie, node, index);
+        if (node != nullptr)
+            prefetchNode(node);
+        lane.node = node;
+    }
+    if (lane.depth < LOOKUP_PATH)
+        lane.path[lane.depth] = node;
+    lane.depth++;
+    return true;
 }
 
-// Retrieves the meaning of a word if found in the Trie, otherwise returns an empty string.
-std::string getMeaning(TrieNode *root, const std::string &word)
+// Looks each block of words up in sorted order, so that repeated prefixes are walked once per
+// lane, and splits the sorted block into LOOKUP_LANES runs that advance one edge at a time in turn.
+// A lane prefetches the node it moves to and only reads it on its next turn, after the other lanes
+// have had theirs, by which time the node has usually arrived. The block is sorted by the first
+// eight bytes of each word packed into an integer: words sharing a longer prefix still end up
+// next to each other, and comparing integers is much cheaper than comparing strings.
+std::vector<std::string_view> getMeanings(const Trie *trie, const std::vector<std::string_view> &words)
 {
-    TrieNode *pCrawl = root;
-    for (char ch : word)
+    METRICS_SCOPE(METRIC_GET_MEANINGS);
+    std::vector<std::string_view> meanings(words.size());
+    TrieNode *root = nodeAt(trie, trie->root);
+    if (root->wordCount < LOOKUP_INTERLEAVE_WORDS)
     {
-        int index = ch - 'a'; // Calculate the index for the character
-        if (pCrawl->children[index] == nullptr)
-            return "";                    // Return an empty string if the word is not found
-        pCrawl = pCrawl->children[index]; // Move to the next node
+        for (size_t i = 0; i < words.size(); i++)
+        {
+            TrieNode *node = findNode(trie, words[i]);
+            if (node != nullptr && node->isEndOfWord)
+                meanings[i] = nodeMeaning(trie, node);
+        }
+        return meanings;
     }
-    return (pCrawl != nullptr && pCrawl->isEndOfWord) ? pCrawl->meaning : ""; // Return meaning if word is valid
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys; // Sort key and index into `words`
+    std::vector<uint32_t> order;
+    LookupLane lanes[LOOKUP_LANES];
+    for (size_t blockStart = 0; blockStart < words.size(); blockStart += LOOKUP_BLOCK)
+    {
+        size_t blockEnd = std::min(blockStart + LOOKUP_BLOCK, words.size());
+        keys.resize(blockEnd - blockStart);
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            std::string_view word = words[blockStart + i];
+            uint64_t key = 0;
+            for (size_t j = 0; j < 8; j++)
+                key = (key << 8) | (j < word.size() ? static_cast<unsigned char>(word[j]) : 0);
+            keys[i] = {key, uint32_t(blockStart + i)};
+        }
+        std::sort(keys.begin(), keys.end(), [](const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b) {
+            return a.first < b.first;
+        });
+        order.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+            order[i] = keys[i].second;
+
+        size_t laneCount = std::min(LOOKUP_LANES, order.size());
+        size_t perLane = (order.size() + laneCount - 1) / laneCount;
+        size_t active = 0;
+        for (size_t begin = 0; begin < order.size(); begin += perLane)
+        {
+            LookupLane &lane = lanes[active++];
+            lane.next = order.data() + begin;
+            lane.end = order.data() + std::min(begin + perLane, order.size());
+            lane.previous = std::string_view();
+            startLookup(lane, root, words[*lane.next]);
+        }
+
+        // Finished lanes are swapped out of the first `active` slots.
+        while (active > 0)
+        {
+            for (size_t i = 0; i < active;)
+            {
+                if (stepLookup(trie, root, lanes[i], words, meanings))
+                    i++;
+                else
+                    std::swap(lanes[i], lanes[--active]);
+            }
+        }
+    }
+    return meanings;
 }
 
 // Depth-first search helper to collect all words and their meanings from the Trie.
-void dfs(TrieNode *node, const std::string &prefix, std::vector<std::pair<std::string, std::string>> &suggestions)
+void dfs(const Trie *trie, TrieNode *node, const std::string &prefix, std::vector<std::pair<std::string, std::string>> &suggestions)
 {
     if (node == nullptr)
         return;
+    std::string buffer;
+    if (node->isEndOfWord)
+        suggestions.push_back({prefix, std::string(readMeaning(trie, node, buffer))}); // Add word and meaning if it's an end of a word
+    forEachChild(trie, node, [&](int i, TrieNode *child) {
+        char letter = 'a' + i;                         // Get character corresponding to index
+        dfs(trie, child, prefix + letter, suggestions); // Recurse into the child node
+    });
+}
+
+// Returns a list of words with their meanings based on the provided prefix.
+std::vector<std::pair<std::string, std::string>> getSuggestions(const Trie *trie, const std::string &prefix)
+{
+    METRICS_SCOPE(METRIC_GET_SUGGESTIONS);
+    TrieNode *pCrawl = findNode(trie, prefix);
+    if (pCrawl == nullptr)
+        return {}; // Return empty vector if no words match the prefix
+    std::vector<std::pair<std::string, std::string>> suggestions;
+    dfs(trie, pCrawl, prefix, suggestions); // Collect all matching words and meanings
+    return suggestions;
+}
+
+// Bounded depth-first walk used by getCompletions(). `word` is a single buffer that is extended
+// and shrunk in place, and whole subtrees that lie before `offset` are skipped using their word counts.
+static void collectCompletions(const Trie *trie, TrieNode *node, std::string &word, size_t &offset, size_t limit, std::vector<std::string> &completions)
+{
     if (node->isEndOfWord)
-        suggestions.push_back({prefix, node->meaning}); // Add word and meaning if it's an end of a word
-    for (int i = 0; i < ALPHABET_SIZE; i++)
     {
-        if (node->children[i] != nullptr)
+        if (offset > 0)
+            offset--; // Still skipping towards the requested offset
+        else
+            completions.push_back(word);
+    }
+    forEachChild(trie, node, [&](int i, TrieNode *child) {
+        if (completions.size() >= limit)
+            return;
+        if (offset >= child->wordCount)
         {
-            char letter = 'a' + i;                                // Get character corresponding to index
-            dfs(node->children[i], prefix + letter, suggestions); // Recurse into the child node
+            offset -= child->wordCount; // The whole subtree lies before the offset
+            return;
         }
+        word.push_back('a' + i);
+        collectCompletions(trie, child, word, offset, limit, completions);
+        word.pop_back();
+    });
+}
+
+// Collects up to `limit` completions below an already located prefix node.
+static std::vector<std::string> completionsFrom(const Trie *trie, TrieNode *node, const std::string &prefix, size_t limit, size_t offset)
+{
+    std::vector<std::string> completions;
+    if (node == nullptr || limit == 0 || offset >= node->wordCount)
+        return completions;
+
+    std::string word = prefix;
+    collectCompletions(trie, node, word, offset, limit, completions);
+    return completions;
+}
+
+// Returns up to `limit` words that share the given prefix, stopping as soon as enough are found.
+std::vector<std::string> getCompletions(const Trie *trie, const std::string &prefix, size_t limit, size_t offset)
+{
+    METRICS_SCOPE(METRIC_GET_COMPLETIONS);
+    return completionsFrom(trie, findNode(trie, prefix), prefix, limit, offset);
+}
+
+// Like collectCompletions(), but only descends into children whose mask shares a bit with the
+// filter. The word counts cover every part of speech, so the offset is skipped one word at a time.
+static void collectFiltered(const Trie *trie, TrieNode *node, uint8_t partsOfSpeech, std::string &word, size_t &offset, size_t limit, std::vector<std::string> &completions)
+{
+    if ((wordPartsOfSpeech(trie, node) & partsOfSpeech) != 0)
+    {
+        if (offset > 0)
+            offset--;
+        else
+            completions.push_back(word);
     }
+    forEachChild(trie, node, [&](int i, TrieNode *child) {
+        if (completions.size() >= limit || (child->partsOfSpeech & partsOfSpeech) == 0)
+            return;
+        word.push_back('a' + i);
+        collectFiltered(trie, child, partsOfSpeech, word, offset, limit, completions);
+        word.pop_back();
+    });
 }
 
-// Returns a list of words with their meanings based on the provided prefix.
-std::vector<std::pair<std::string, std::string>> getSuggestions(TrieNode *root, const std::string &prefix)
+// Collects up to `limit` filtered completions below an already located prefix node.
+static std::vector<std::string> filteredFrom(const Trie *trie, TrieNode *node, const std::string &prefix, uint8_t partsOfSpeech, size_t limit, size_t offset)
+{
+    std::vector<std::string> completions;
+    if (node == nullptr || limit == 0 || (node->partsOfSpeech & partsOfSpeech) == 0)
+        return completions;
+
+    std::string word = prefix;
+    collectFiltered(trie, node, partsOfSpeech, word, offset, limit, completions);
+    return completions;
+}
+
+// Returns up to `limit` words that share the prefix and have one of the parts of speech.
+std::vector<std::string> getFilteredCompletions(const Trie *trie, const std::string &prefix, uint8_t partsOfSpeech, size_t limit, size_t offset)
+{
+    return filteredFrom(trie, findNode(trie, prefix), prefix, partsOfSpeech, limit, offset);
+}
+
+// Returns the number of words that share the given prefix.
+size_t countWords(const Trie *trie, const std::string &prefix)
 {
-    TrieNode *pCrawl = root;
-    for (char ch : prefix)
+    TrieNode *pCrawl = findNode(trie, prefix);
+    return pCrawl != nullptr ? pCrawl->wordCount : 0;
+}
+
+// State shared by the steps of a fuzzy search. rows holds one row of the edit distance table per
+// depth of the walk: entry j of the row at depth k is the distance between the first j letters of
+// the query and the k letters of the path to the current node.
+struct FuzzySearch {
+    const Trie *trie;
+    std::string query; // The query's letters, lowercased
+    int maxDistance;
+    size_t limit;
+    std::vector<int> rows;
+    std::string word; // Letters on the path to the current node
+    std::vector<FuzzyMatch> matches; // Sorted by distance, then found order (alphabetical)
+};
+
+// Returns the largest distance a new match can have and still be kept. Once `limit` matches are
+// held, a later word needs a smaller distance than the worst of them, since it comes later
+// alphabetically.
+static int fuzzyBound(const FuzzySearch &search)
+{
+    if (search.matches.size() < search.limit)
+        return search.maxDistance;
+    return search.matches.back().distance - 1;
+}
+
+// Keeps a match in distance order, dropping the worst one if there are more than `limit`.
+static void addFuzzyMatch(FuzzySearch &search, int distance)
+{
+    auto position = std::upper_bound(search.matches.begin(), search.matches.end(), distance,
+                                     [](int d, const FuzzyMatch &match) { return d < match.distance; });
+    search.matches.insert(position, FuzzyMatch{search.word, distance});
+    if (search.matches.size() > search.limit)
+        search.matches.pop_back();
+}
+
+// Depth-first walk that fills in one table row per edge. A row's smallest entry is a lower bound
+// on the distance of every word below the node, so the subtree is skipped once it exceeds the bound.
+static void fuzzyWalk(FuzzySearch &search, const TrieNode *node, size_t depth)
+{
+    size_t width = search.query.size() + 1;
+    const int *row = &search.rows[depth * width];
+    bool inBand = depth + size_t(search.maxDistance) >= width - 1; // Else the word is too short to match
+    if (node->isEndOfWord && inBand && row[width - 1] <= fuzzyBound(search))
+        addFuzzyMatch(search, row[width - 1]);
+
+    // Entries more than maxDistance off the diagonal always exceed it, so only the band around the
+    // diagonal is computed; the entry just past each end of the band is capped at maxDistance + 1.
+    size_t first = depth + 1 > size_t(search.maxDistance) ? depth + 1 - size_t(search.maxDistance) : 0;
+    size_t last = std::min(width - 1, depth + 1 + size_t(search.maxDistance));
+    int outside = search.maxDistance + 1;
+    forEachChild(search.trie, node, [&](int index, TrieNode *child) {
+        int *next = &search.rows[(depth + 1) * width];
+        int smallest = outside;
+        if (first == 0)
+            smallest = next[0] = row[0] + 1;
+        else
+            next[first - 1] = outside;
+        for (size_t j = std::max(first, size_t(1)); j <= last; j++)
+        {
+            int substitute = row[j - 1] + (search.query[j - 1] - 'a' != index);
+            next[j] = std::min(std::min(row[j], next[j - 1]) + 1, substitute);
+            smallest = std::min(smallest, next[j]);
+        }
+        if (last + 1 < width)
+            next[last + 1] = outside;
+        if (smallest > fuzzyBound(search))
+            return; // No word below this child is close enough
+        search.word.push_back(char('a' + index));
+        fuzzyWalk(search, child, depth + 1);
+        search.word.pop_back();
+    });
+}
+
+// Walks the trie with one row of the edit distance table per level.
+std::vector<FuzzyMatch> getFuzzyMatches(const Trie *trie, const std::string &word, int maxDistance, size_t limit)
+{
+    METRICS_SCOPE(METRIC_FUZZY_MATCHES);
+    FuzzySearch search{trie, std::string(), maxDistance, limit, {}, std::string(), {}};
+    if (limit == 0 || maxDistance < 0)
+        return {};
+    for (char ch : word)
     {
-        int index = ch - 'a'; // Calculate the index for the character
-        if (pCrawl->children[index] == nullptr)
-            return {};                    // Return empty vector if no words match the prefix
-        pCrawl = pCrawl->children[index]; // Move to the next node
+        int index = letterIndex(ch);
+        if (index >= 0)
+            search.query.push_back(char('a' + index));
     }
-    std::vector<std::pair<std::string, std::string>> suggestions;
-    dfs(pCrawl, prefix, suggestions); // Collect all matching words and meanings
-    return suggestions;
+
+    // A path longer than the query by more than maxDistance is pruned, which bounds the depth.
+    size_t width = search.query.size() + 1;
+    search.rows.resize((search.query.size() + size_t(maxDistance) + 2) * width);
+    for (size_t j = 0; j < width; j++)
+        search.rows[j] = int(j);
+    fuzzyWalk(search, nodeAt(trie, trie->root), 0);
+    return search.matches;
 }
 
-// Recursively removes a word from the Trie.
-TrieNode *remove(TrieNode *root, const std::string &word)
+// Points the cursor at the given text, moving only along the part that differs from its current prefix.
+void cursorSeek(PrefixCursor &cursor, const Trie *trie, const std::string &text)
 {
-    if (root == nullptr)
+    if (cursor.trie != trie || cursor.version != trie->version)
+    {
+        // Nodes on the remembered path may have been removed; start again from the root.
+        cursor.trie = trie;
+        cursor.version = trie->version;
+        cursor.prefix.clear();
+        cursor.path.clear();
+    }
+
+    size_t common = 0;
+    while (common < cursor.prefix.size() && common < text.size() && cursor.prefix[common] == text[common])
+        common++;
+    while (cursor.prefix.size() > common)
+        cursorPop(cursor);
+    for (size_t i = common; i < text.size(); i++)
+        cursorPush(cursor, text[i]);
+}
+
+// Advances the cursor by one character, following a single edge.
+void cursorPush(PrefixCursor &cursor, char ch)
+{
+    TrieNode *node = cursorNode(cursor);
+    int index = letterIndex(ch);
+    if (node != nullptr && index >= 0)
+        node = findChild(cursor.trie, node, index); // Non-letters keep the cursor where it is, as in insert()
+    cursor.prefix.push_back(ch);
+    cursor.path.push_back(node);
+}
+
+// Moves the cursor back by one character by popping the path stack.
+void cursorPop(PrefixCursor &cursor)
+{
+    if (cursor.prefix.empty())
+        return;
+    cursor.prefix.pop_back();
+    cursor.path.pop_back();
+}
+
+// Returns the node for the cursor's prefix (the root for an empty prefix).
+TrieNode *cursorNode(const PrefixCursor &cursor)
+{
+    if (cursor.trie == nullptr)
         return nullptr;
+    return cursor.path.empty() ? nodeAt(cursor.trie, cursor.trie->root) : cursor.path.back();
+}
 
-    if (word.empty())
+// Returns up to `limit` completions of the cursor's prefix.
+std::vector<std::string> getCompletions(const PrefixCursor &cursor, size_t limit, size_t offset)
+{
+    METRICS_SCOPE(METRIC_GET_COMPLETIONS);
+    return completionsFrom(cursor.trie, cursorNode(cursor), cursor.prefix, limit, offset);
+}
+
+// Returns up to `limit` words that start with the cursor's prefix and have one of the parts of speech.
+std::vector<std::string> getFilteredCompletions(const PrefixCursor &cursor, uint8_t partsOfSpeech, size_t limit, size_t offset)
+{
+    return filteredFrom(cursor.trie, cursorNode(cursor), cursor.prefix, partsOfSpeech, limit, offset);
+}
+
+// Returns the number of words that start with the cursor's prefix.
+size_t countWords(const PrefixCursor &cursor)
+{
+    TrieNode *node = cursorNode(cursor);
+    return node != nullptr ? node->wordCount : 0;
+}
+
+// Ranks ahead of a CompletionIterator that completionSeek() steps through one word at a time.
+// Stepping costs about one edge per word, while seeking from the prefix node costs a scan of the
+// children at every level of the path, so only short moves (scrolling by a row or a page) step.
+static const size_t COMPLETION_STEP_LIMIT = 64;
+
+// Returns the letter index of a node's first child after the letter index `after` (-1 for its
+// first child) and sets `child` to it, or returns -1 if there is none.
+static int nextChild(const Trie *trie, const TrieNode *node, int after, const TrieNode *&child)
+{
+    switch (node->type)
+    {
+    case NODE_4:
+    {
+        const TrieNode4 *n = static_cast<const TrieNode4 *>(node);
+        for (int i = 0; i < n->numChildren; i++)
+        {
+            if (n->keys[i] > after)
+            {
+                child = nodeAt(trie, n->children[i]);
+                return n->keys[i];
+            }
+        }
+        return -1;
+    }
+    case NODE_16:
     {
-        if (root->isEndOfWord)
+        const TrieNode16 *n = static_cast<const TrieNode16 *>(node);
+        for (int i = 0; i < n->numChildren; i++)
         {
-            root->isEndOfWord = false; // Unmark the word as the end of the word
+            if (n->keys[i] > after)
+            {
+                child = nodeAt(trie, n->children[i]);
+                return n->keys[i];
+            }
         }
-        bool isEmpty = true;
-        for (int i = 0; i < ALPHABET_SIZE; i++)
+        return -1;
+    }
+    case NODE_FULL:
+    {
+        const TrieNodeFull *n = static_cast<const TrieNodeFull *>(node);
+        for (int i = after + 1; i < ALPHABET_SIZE; i++)
         {
-            if (root->children[i] != nullptr)
+            if (n->children[i] != NO_NODE)
             {
-                isEmpty = false; // Check if any child exists
-                break;
+                child = nodeAt(trie, n->children[i]);
+                return i;
             }
         }
-        if (isEmpty)
+        return -1;
+    }
+    default:
+        return -1;
+    }
+}
+
+// Rebuilds the iterator's path from the prefix node down to the completion of the given rank.
+// At every level, the subtrees of the children before the one holding that rank are skipped
+// by their word counts.
+static void descendToRank(CompletionIterator &iterator, size_t rank)
+{
+    iterator.path.clear();
+    iterator.word = iterator.prefix;
+    iterator.rank = rank;
+    if (rank >= iterator.total)
+        return;
+
+    const TrieNode *node = iterator.top;
+    while (true)
+    {
+        iterator.path.push_back({node, -1});
+        if (node->isEndOfWord)
         {
-            delete root; // Delete the node if it's empty
-            root = nullptr;
+            if (rank == 0)
+                return;
+            rank--;
         }
-        return root;
+        // rank is below the words left in this subtree, so some child holds it.
+        const TrieNode *child = nullptr;
+        int index = -1;
+        while ((index = nextChild(iterator.trie, node, index, child)) >= 0 && rank >= child->wordCount)
+            rank -= child->wordCount;
+        iterator.path.back().child = index;
+        iterator.word.push_back(char('a' + index));
+        node = child;
     }
+}
 
-    int index = word[0] - 'a';                                             // Get the index for the current character
-    root->children[index] = remove(root->children[index], word.substr(1)); // Recurse and remove the word
+// Starts again from the prefix node if the cursor moved or the Trie changed since the last seek.
+void completionSeek(CompletionIterator &iterator, const PrefixCursor &cursor, size_t rank)
+{
+    unsigned long version = cursor.trie != nullptr ? cursor.trie->version.load() : 0;
+    if (iterator.trie != cursor.trie || iterator.version != version || iterator.prefix != cursor.prefix)
+    {
+        iterator.trie = cursor.trie;
+        iterator.version = version;
+        iterator.top = cursorNode(cursor);
+        iterator.prefix = cursor.prefix;
+        iterator.total = iterator.top != nullptr ? iterator.top->wordCount : 0;
+        descendToRank(iterator, std::min(rank, iterator.total));
+        return;
+    }
 
-    // If current node is not the end of a word, and it has no children, delete the node
-    if (!root->isEndOfWord)
+    rank = std::min(rank, iterator.total);
+    if (rank >= iterator.rank && rank - iterator.rank <= COMPLETION_STEP_LIMIT)
     {
-        bool hasChild = false;
+        while (iterator.rank < rank && completionNext(iterator))
+            ;
+        return;
+    }
+    descendToRank(iterator, rank);
+}
+
+// The next completion is the first word in the current word's subtree after the word itself, or
+// else the first word below a later child of the nearest node up the path that has one.
+bool completionNext(CompletionIterator &iterator)
+{
+    if (!completionValid(iterator))
+        return false;
+    if (++iterator.rank == iterator.total)
+    {
+        iterator.path.clear();
+        iterator.word = iterator.prefix;
+        return false;
+    }
+
+    // A later word exists, so the walk never climbs above the prefix node.
+    while (true)
+    {
+        CompletionFrame &frame = iterator.path.back();
+        const TrieNode *child = nullptr;
+        int index = nextChild(iterator.trie, frame.node, frame.child, child);
+        if (index < 0)
+        {
+            iterator.path.pop_back();
+            iterator.word.pop_back();
+            continue;
+        }
+        frame.child = index;
+        iterator.word.push_back(char('a' + index));
+        iterator.path.push_back({child, -1});
+        if (child->isEndOfWord)
+            return true;
+    }
+}
+
+// Counts the words before `word` along its path: the node's own word, then the subtrees of the
+// children before the next letter, at every level below the prefix.
+bool completionRank(const PrefixCursor &cursor, std::string_view word, size_t &rank)
+{
+    rank = 0;
+    const TrieNode *node = cursorNode(cursor);
+    if (node == nullptr)
+        return false;
+
+    size_t prefixLetters = 0;
+    for (char ch : cursor.prefix)
+        prefixLetters += letterIndex(ch) >= 0;
+    for (char ch : word)
+    {
+        int index = letterIndex(ch);
+        if (index < 0)
+            continue;
+        if (prefixLetters > 0)
+        {
+            prefixLetters--;
+            continue;
+        }
+        if (node->isEndOfWord)
+            rank++;
+        const TrieNode *child = nullptr;
+        int next = -1;
+        while ((next = nextChild(cursor.trie, node, next, child)) >= 0 && next < index)
+            rank += child->wordCount;
+        if (next != index)
+            return false;
+        node = child;
+    }
+    return node->isEndOfWord;
+}
+
+// Collects the slots of a node that hold a child into `slots`. Returns how many there are.
+static int childSlots(TrieNode *node, NodeRef **slots)
+{
+    int count = 0;
+    if (node->type == NODE_4 || node->type == NODE_16)
+    {
+        NodeRef *children = node->type == NODE_4 ? static_cast<TrieNode4 *>(node)->children : static_cast<TrieNode16 *>(node)->children;
+        for (; count < node->numChildren; count++)
+            slots[count] = &children[count];
+    }
+    else if (node->type == NODE_FULL)
+    {
+        TrieNodeFull *full = static_cast<TrieNodeFull *>(node);
         for (int i = 0; i < ALPHABET_SIZE; i++)
         {
-            if (root->children[i])
-            {
-                hasChild = true;
-                break;
-            }
+            if (full->children[i] != NO_NODE)
+                slots[count++] = &full->children[i];
+        }
+    }
+    return count;
+}
+
+// Adds `delta` to every child handle and `meaningDelta` to every meaning offset in a trie, in place.
+// The trie is walked through its own arena, so each handle is read before it is rewritten.
+// Iterative, so long words cannot overflow the stack.
+static void rebaseTrie(Trie *trie, NodeRef delta, uint32_t meaningDelta)
+{
+    std::vector<NodeRef> stack(1, trie->root);
+    NodeRef *slots[ALPHABET_SIZE];
+    while (!stack.empty())
+    {
+        TrieNode *node = nodeAt(trie, stack.back());
+        stack.pop_back();
+        if (node->meaningLength > 0)
+            node->meaningOffset += meaningDelta;
+        int count = childSlots(node, slots);
+        for (int i = 0; i < count; i++)
+        {
+            stack.push_back(*slots[i]);
+            *slots[i] += delta;
+        }
+    }
+}
+
+// Where each part's slabs and chunks will land follows from the counts alone, so all parts are
+// rebased in parallel first. Then, one part at a time, its slabs and chunks are moved over, its
+// root's children are hung off the trie's root, and its root is freed.
+void mergeTries(Trie *trie, std::vector<Trie *> &parts)
+{
+    assert(!trie->codec.trained());
+    trie->version++;
+    std::vector<NodeRef> deltas;
+    std::vector<uint32_t> meaningDeltas;
+    size_t slabs = trie->nodes.slabCount(), chunks = trie->meanings.chunkList().size();
+    for (Trie *part : parts)
+    {
+        deltas.push_back(NodeRef(slabs << NodeArena::OFFSET_BITS));
+        meaningDeltas.push_back(uint32_t(chunks << MeaningPool::CHUNK_BITS));
+        slabs += part->nodes.slabCount();
+        chunks += part->meanings.chunkList().size();
+    }
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < parts.size(); i++)
+        workers.emplace_back(rebaseTrie, parts[i], deltas[i], meaningDeltas[i]);
+    for (std::thread &worker : workers)
+        worker.join();
+
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+        Trie *part = parts[p];
+        trie->nodes.absorb(part->nodes);
+        trie->meanings.absorb(part->meanings);
+        trie->nodeCount += part->nodeCount;
+        NodeRef partRoot = part->root + deltas[p];
+
+        TrieNode *from = nodeAt(trie, partRoot);
+        uint8_t keys[ALPHABET_SIZE];
+        NodeRef refs[ALPHABET_SIZE];
+        int count = copyChildren(from, keys, refs);
+        NodeRef rootRef = trie->root;
+        for (int i = 0; i < count; i++)
+        {
+            addChild(trie, rootRef, keys[i], refs[i]);
+            nodeAt(trie, rootRef)->wordCount += nodeAt(trie, refs[i])->wordCount;
+        }
+        trie->root = rootRef;
+        if (from->isEndOfWord)
+        {
+            TrieNode *root = nodeAt(trie, rootRef);
+            if (!root->isEndOfWord)
+                root->wordCount++;
+            root->isEndOfWord = true;
+            root->meaningOffset = from->meaningOffset;
+            root->meaningLength = from->meaningLength;
         }
-        if (!hasChild)
+        freeNode(trie, partRoot);
+        updatePartsOfSpeech(trie, nodeAt(trie, rootRef));
+
+        delete part; // Its arena and pool are empty now
+        parts[p] = nullptr;
+    }
+}
+
+// Recursive helper for remove(). `slot` holds the handle of the current node and is updated when
+// the node changes layout. Sets `removed` when the word was present, so that the subtree counts
+// along the path are only decremented for a real removal. Returns true once the node no longer
+// holds a word or leads to one and has been freed.
+static bool removeHelper(Trie *trie, NodeRef &slot, const std::string &word, size_t depth, bool &removed, bool isRoot = false)
+{
+    TrieNode *node = nodeAt(trie, slot);
+
+    // Skip characters that insert() would have ignored.
+    while (depth < word.size() && letterIndex(word[depth]) < 0)
+        depth++;
+
+    if (depth == word.size())
+    {
+        if (node->isEndOfWord)
         {
-            delete root;
-            root = nullptr;
+            node->isEndOfWord = false; // Unmark the word as the end of the word
+            node->meaningLength = 0;
+            node->wordCount--;
+            removed = true;
         }
     }
-    return root;
+    else
+    {
+        int index = letterIndex(word[depth]); // Get the index for the current character
+        NodeRef *child = findSlot(node, index);
+        if (child == nullptr)
+            return false; // The word is not in the Trie
+        bool childFreed = removeHelper(trie, *child, word, depth + 1, removed); // Recurse and remove the word
+        if (removed)
+            node->wordCount--;
+        if (childFreed)
+            removeChild(trie, slot, index); // May move the node to a smaller layout
+    }
+
+    // A node that is not the end of a word and has no children is no longer needed (the root always stays).
+    node = nodeAt(trie, slot);
+    if (removed)
+        updatePartsOfSpeech(trie, node); // The removed word's parts of speech may have been the only ones
+    if (!isRoot && !node->isEndOfWord && node->numChildren == 0)
+    {
+        freeNode(trie, slot);
+        slot = NO_NODE;
+        return true;
+    }
+    return false;
+}
+
+// Removes a word from the Trie.
+bool remove(Trie *trie, const std::string &word)
+{
+    trie->version++;
+    bool removed = false;
+    NodeRef root = trie->root;
+    removeHelper(trie, root, word, 0, removed, true);
+    if (root != trie->root)
+        trie->root = root;
+    return removed;
+}
+
+// Replaces every node on the word's path under `root` (as far as the path exists) with a copy,
+// so the caller can change the copies while readers still walk the originals. The copies are not
+// counted in nodeCount since they take the originals' place; the originals are added to `retired`.
+static void copyPath(Trie *trie, NodeRef &root, std::string_view word, std::vector<NodeRef> &retired)
+{
+    NodeRef *slot = &root;
+    size_t pos = 0;
+    while (slot != nullptr)
+    {
+        const TrieNode *original = nodeAt(trie, *slot);
+        size_t size = nodeSize(original->type);
+        NodeRef copy = trie->nodes.allocate(size);
+        std::memcpy(nodeAt(trie, copy), original, size);
+        retired.push_back(*slot);
+        *slot = copy;
+
+        int index = -1;
+        while (pos < word.size() && index < 0)
+            index = letterIndex(word[pos++]);
+        slot = index >= 0 ? findSlot(nodeAt(trie, copy), index) : nullptr;
+    }
+}
+
+// The copied path is changed with the same code as insert(), then published with one atomic store.
+void insertCopy(Trie *trie, std::string_view word, std::string_view meaning, std::vector<NodeRef> &retired)
+{
+    NodeRef root = trie->root;
+    copyPath(trie, root, word, retired);
+    uint32_t length;
+    uint32_t offset = storeMeaning(trie, meaning, length);
+    insertAt(trie, root, word, meaning, offset, length);
+    trie->root.store(root);
+    trie->version++;
+}
+
+// A word that is not there changes nothing, so no path is copied for it.
+bool removeCopy(Trie *trie, const std::string &word, std::vector<NodeRef> &retired)
+{
+    if (!search(trie, word))
+        return false;
+    NodeRef root = trie->root;
+    copyPath(trie, root, word, retired);
+    bool removed = false;
+    removeHelper(trie, root, word, 0, removed, true);
+    trie->root.store(root);
+    trie->version++;
+    return removed;
+}
+
+// The node was replaced by a copy, which took over its place in nodeCount.
+void freeRetiredNode(Trie *trie, NodeRef ref)
+{
+    trie->nodes.deallocate(ref, nodeSize(nodeAt(trie, ref)->type));
 }
 
-// Deletes the entire Trie by recursively removing all nodes.
-void deleteTrie(TrieNode *&root)
+// Reports the node memory of the Trie.
+TrieMemoryUsage getMemoryUsage(const Trie *trie)
 {
-    if (!root)
+    TrieMemoryUsage usage;
+    usage.nodeCount = trie->nodeCount;
+    usage.nodeBytesUsed = trie->nodes.bytesUsed();
+    usage.nodeBytesReserved = trie->nodes.bytesReserved();
+    usage.meaningBytesUsed = trie->meanings.bytesUsed();
+    usage.meaningBytesReserved = trie->meanings.bytesReserved();
+    return usage;
+}
+
+// Every meaning is encoded into a new pool before the old one is dropped, so the peak holds both.
+void compressMeanings(Trie *trie)
+{
+    if (trie->codec.trained())
         return;
-    for (int i = 0; i < ALPHABET_SIZE; i++)
+    std::vector<TrieNode *> words;
+    std::vector<TrieNode *> stack = {nodeAt(trie, trie->root)};
+    while (!stack.empty())
     {
-        deleteTrie(root->children[i]); // Recurse to delete all child nodes
+        TrieNode *node = stack.back();
+        stack.pop_back();
+        if (node->isEndOfWord)
+            words.push_back(node);
+        forEachChild(trie, node, [&](int, TrieNode *child) { stack.push_back(child); });
     }
-    delete root;    // Delete the current node
-    root = nullptr; // Nullify the root pointer
+
+    std::vector<std::string_view> texts;
+    texts.reserve(words.size());
+    for (TrieNode *node : words)
+        texts.push_back(trie->meanings.get(node->meaningOffset, node->meaningLength));
+    trie->codec.train(texts);
+
+    MeaningPool encoded;
+    std::string code;
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        code.clear();
+        trie->codec.encode(texts[i], code);
+        words[i]->meaningOffset = encoded.append(code);
+        words[i]->meaningLength = uint32_t(code.size());
+    }
+    trie->codec.releaseEncoder(); // Built again by the next insert, if any
+    trie->meanings.release();
+    trie->meanings.absorb(encoded); // The pool is empty, so offsets are unchanged
+    trie->meaningText.close();
+    trie->version++;
+}
+
+// Deletes the entire Trie. Nodes are trivially destructible and meanings live in the pool, so nothing
+// is freed one node at a time: the arena and the pool each drop all of their memory at once.
+void deleteTrie(Trie *&trie)
+{
+    if (!trie)
+        return;
+    trie->nodes.release();    // Free every node slab in one step
+    trie->meanings.release(); // Free every meaning chunk in one step
+    trie->image.close();      // Unmap the dictionary image, if the trie was opened from one
+    trie->meaningText.close(); // Unmap the meaning file, if the trie was loaded lazily
+    delete trie;              // Delete the trie handle
+    trie = nullptr;           // Nullify the trie pointer
 }
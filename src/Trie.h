@@ -1,35 +1,300 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <atomic>
+#include <cctype>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "NodeArena.h"
+#include "MeaningPool.h"
+#include "MeaningCodec.h"
+#include "MappedFile.h"
+#include "PartOfSpeech.h"
 
 const int ALPHABET_SIZE = 26;
 
+// Maps a character to its letter index (0-25), or -1 if it is not a letter. Words are stored under
+// their letters alone, lowercased, so every structure keyed by word spells it this way.
+inline int letterIndex(char ch)
+{
+    int index = tolower(static_cast<unsigned char>(ch)) - 'a';
+    return (index >= 0 && index < ALPHABET_SIZE) ? index : -1;
+}
+
+// Keeps the letters of a word, lowercased: the key a trie stores it under.
+std::string wordKey(std::string_view word);
+
+// Node layouts. A node uses the smallest layout that holds its children and is grown or shrunk
+// as insert() and remove() add or drop children, so most nodes (leaves and the long single-child
+// chains below the first few letters) cost tens of bytes instead of a full array of 26 children.
+enum NodeType : uint8_t {
+    NODE_LEAF, // No children
+    NODE_4,    // Up to 4 children, keys kept sorted
+    NODE_16,   // Up to 16 children, keys kept sorted and searched with SIMD
+    NODE_FULL  // One slot per letter
+};
+
+// Header shared by every node layout. Children are referred to by 32-bit arena handles.
 struct TrieNode {
+    uint8_t type;             // NodeType of this node
+    uint8_t numChildren;
     bool isEndOfWord;
-    std::string meaning;
-    TrieNode *children[ALPHABET_SIZE];
+    uint8_t partsOfSpeech;    // PartOfSpeech bits of every word in this node's subtree, including the node itself
+    unsigned int wordCount;   // Number of words stored in this node's subtree, including the node itself
+    uint32_t meaningOffset;   // Location of the word's meaning in the trie's meaning pool
+    uint32_t meaningLength;
+};
+
+struct TrieNode4 : TrieNode {
+    uint8_t keys[4]; // Letter indices of the children, ascending
+    NodeRef children[4];
+};
+
+struct TrieNode16 : TrieNode {
+    uint8_t keys[16]; // Letter indices of the children, ascending
+    NodeRef children[16];
+};
+
+struct TrieNodeFull : TrieNode {
+    NodeRef children[ALPHABET_SIZE]; // Indexed by letter, NO_NODE where there is no child
+};
+
+// A dictionary trie. All nodes live in the trie's own arena and all meanings in its
+// meaning pool, so both are freed together. A trie opened from a dictionary image also owns the
+// mapping its first slabs and chunks live in, and a lazily loaded one the mapping of the meaning
+// file its first chunks are windows of. Once compressMeanings() has trained the codec, the pool
+// holds every meaning encoded with it.
+//
+// The root and the version are atomic so that a VersionedTrie can publish a new root while
+// readers on other threads walk the old one. Queries load the root once, at the start.
+struct Trie {
+    MappedFile image;
+    MappedFile meaningText;
+    std::atomic<NodeRef> root{NO_NODE};
+    NodeArena nodes;
+    MeaningPool meanings;
+    MeaningCodec codec;
+    size_t nodeCount = 0;                   // Live nodes, including the root
+    std::atomic<unsigned long> version{0};  // Bumped by every modification so cursors and caches can tell they are stale
 };
 
-// Creates a new trie node.
-TrieNode *getNode();
+// Memory held by a trie's nodes and meanings.
+struct TrieMemoryUsage {
+    size_t nodeCount;
+    size_t nodeBytesUsed;        // Bytes in live nodes
+    size_t nodeBytesReserved;    // Bytes in arena slabs, including free and not yet carved space
+    size_t meaningBytesUsed;     // Bytes appended to the meaning pool
+    size_t meaningBytesReserved; // Bytes in meaning pool chunks
+};
+
+// Creates an empty trie.
+Trie *createTrie();
+
+// Creates a new trie node of the given layout in the trie's arena.
+NodeRef getNode(Trie *trie, NodeType type = NODE_LEAF);
+
+// Translates a node handle into the node.
+inline TrieNode *nodeAt(const Trie *trie, NodeRef ref)
+{
+    return static_cast<TrieNode *>(trie->nodes.pointer(ref));
+}
+
+// Returns the child of a node for a letter index (0-25), or nullptr if there is none.
+TrieNode *findChild(const Trie *trie, const TrieNode *node, int index);
+
+// Calls visit(index, child) for every child of a node in alphabetical order.
+template <typename Visit>
+void forEachChild(const Trie *trie, const TrieNode *node, Visit visit)
+{
+    switch (node->type)
+    {
+    case NODE_4:
+    {
+        const TrieNode4 *n = static_cast<const TrieNode4 *>(node);
+        for (int i = 0; i < n->numChildren; i++)
+            visit(n->keys[i], nodeAt(trie, n->children[i]));
+        break;
+    }
+    case NODE_16:
+    {
+        const TrieNode16 *n = static_cast<const TrieNode16 *>(node);
+        for (int i = 0; i < n->numChildren; i++)
+            visit(n->keys[i], nodeAt(trie, n->children[i]));
+        break;
+    }
+    case NODE_FULL:
+    {
+        const TrieNodeFull *n = static_cast<const TrieNodeFull *>(node);
+        for (int i = 0; i < ALPHABET_SIZE; i++)
+        {
+            if (n->children[i] != NO_NODE)
+                visit(i, nodeAt(trie, n->children[i]));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
 
-// Inserts a word and its meaning into the trie.
-void insert(TrieNode *root, const std::string &word, const std::string &meaning);
+// Inserts a word and its meaning into the trie. Both are copied, so views into a read buffer are fine.
+void insert(Trie *trie, std::string_view word, std::string_view meaning);
+
+// Same as insert(), but the meaning is already stored in the trie's meaning pool (e.g. in a chunk
+// borrowed from a mapped file) and is referred to instead of copied.
+void insertStored(Trie *trie, std::string_view word, uint32_t meaningOffset, uint32_t meaningLength);
 
 // Checks if a word exists in the trie.
-bool search(TrieNode *root, const std::string &word);
+bool search(const Trie *trie, const std::string &word);
+
+// Returns the meaning of the word if it exists; otherwise, returns an empty view.
+// The view points into the trie's meaning pool and stays valid until the trie is deleted.
+// The trie's meanings must not be compressed.
+std::string_view getMeaning(const Trie *trie, const std::string &word);
+
+// Same as getMeaning(), but also for a trie whose meanings are compressed: the meaning is then
+// decoded into `buffer` and the view points there, until the buffer is next used.
+std::string_view getMeaning(const Trie *trie, const std::string &word, std::string &buffer);
 
-// Returns the meaning of the word if it exists; otherwise, returns an empty string.
-std::string getMeaning(TrieNode *root, const std::string &word);
+// Returns the meaning of the word ending at a node, decoded into `buffer` if the trie's meanings
+// are compressed.
+std::string_view readMeaning(const Trie *trie, const TrieNode *node, std::string &buffer);
+
+// Same as calling getMeaning() for each word, but faster for many words: shared prefixes are walked
+// once and several lookups are interleaved so their cache misses overlap. meanings[i] is the
+// meaning of words[i], or an empty view if it is not a word. The words are not copied.
+// The trie's meanings must not be compressed.
+std::vector<std::string_view> getMeanings(const Trie *trie, const std::vector<std::string_view> &words);
+
+// Trains the trie's codec on its meanings and replaces the meaning pool with one holding every
+// meaning encoded, typically at under half the size. Only the symbols needed to decode are kept
+// afterwards; the codec's encoding tables are built again when a meaning is next added, and
+// meanings added later are encoded as they are stored. A lazily loaded trie's meaning file is
+// unmapped. Does nothing if already compressed. Meanings must then be read with readMeaning() or
+// the getMeaning() that takes a buffer. No other thread may read the trie meanwhile.
+void compressMeanings(Trie *trie);
 
 // Returns a vector of (word, meaning) suggestions that share the given prefix.
-std::vector<std::pair<std::string, std::string>> getSuggestions(TrieNode *root, const std::string &prefix);
+std::vector<std::pair<std::string, std::string>> getSuggestions(const Trie *trie, const std::string &prefix);
+
+// Returns up to `limit` words that share the given prefix, in alphabetical order,
+// skipping the first `offset` matches. Meanings are not copied.
+std::vector<std::string> getCompletions(const Trie *trie, const std::string &prefix, size_t limit, size_t offset = 0);
+
+// Returns the number of words that share the given prefix, without walking the subtree.
+size_t countWords(const Trie *trie, const std::string &prefix);
+
+// Same as getCompletions(), but only returns words with at least one of the given parts of speech
+// (PartOfSpeech bits). Subtrees holding none of them are skipped without being visited.
+std::vector<std::string> getFilteredCompletions(const Trie *trie, const std::string &prefix, uint8_t partsOfSpeech, size_t limit, size_t offset = 0);
+
+// A word found by getFuzzyMatches(), with its edit distance from the query.
+struct FuzzyMatch {
+    std::string word;
+    int distance;
+};
+
+// Returns up to `limit` words within `maxDistance` single-letter insertions, deletions or
+// substitutions of the given word, closest first and alphabetical among equals. Non-letters in
+// the word are ignored, as in insert(). Subtrees that cannot come within the distance are never
+// visited, so the cost depends on the distance rather than on the number of words.
+std::vector<FuzzyMatch> getFuzzyMatches(const Trie *trie, const std::string &word, int maxDistance, size_t limit);
+
+// Remembers the path from the root to the node of the current prefix, so that typing or
+// deleting a character only moves along one edge instead of re-walking from the root.
+struct PrefixCursor {
+    const Trie *trie = nullptr;
+    unsigned long version = 0;    // Trie version the path was built against
+    std::string prefix;           // Text the cursor currently points at
+    std::vector<TrieNode *> path; // path[i] is the node reached after prefix[i], or nullptr once off the Trie
+};
+
+// Points the cursor at the given text, reusing the longest common prefix with its current
+// position. The path is rebuilt from the root if the Trie was modified since the last move.
+void cursorSeek(PrefixCursor &cursor, const Trie *trie, const std::string &text);
+
+// Advances the cursor by one character.
+void cursorPush(PrefixCursor &cursor, char ch);
+
+// Moves the cursor back by one character.
+void cursorPop(PrefixCursor &cursor);
+
+// Returns the node for the cursor's prefix, or nullptr if no word starts with it.
+TrieNode *cursorNode(const PrefixCursor &cursor);
+
+// Same as getCompletions()/countWords(), starting from the cursor's node instead of the root.
+std::vector<std::string> getCompletions(const PrefixCursor &cursor, size_t limit, size_t offset = 0);
+std::vector<std::string> getFilteredCompletions(const PrefixCursor &cursor, uint8_t partsOfSpeech, size_t limit, size_t offset = 0);
+size_t countWords(const PrefixCursor &cursor);
+
+// A node on a CompletionIterator's path, and the letter index of the child the path continues
+// into (-1 at the iterator's current word).
+struct CompletionFrame {
+    const TrieNode *node;
+    int child;
+};
+
+// Walks the completions of a prefix one word at a time in alphabetical order, keeping the path to
+// the current word on a stack instead of collecting the words. It can be left anywhere and resumed
+// later, and moved to the word of any rank using the subtree word counts, so showing rows n..n+k
+// of a long list costs about k steps whatever n is. The path is only valid until the Trie is
+// modified; completionSeek() notices and starts again from the prefix.
+struct CompletionIterator {
+    const Trie *trie = nullptr;
+    unsigned long version = 0;         // Trie version the path was built against
+    const TrieNode *top = nullptr;     // Node of the prefix
+    std::string prefix;
+    size_t rank = 0;                   // Rank of `word` among the completions; `total` once past the last
+    size_t total = 0;                  // Number of completions
+    std::string word;                  // Current completion, the prefix followed by the letters on the path
+    std::vector<CompletionFrame> path; // From the prefix node down to the node of `word`
+};
+
+// Points the iterator at the completion of the cursor's prefix with the given rank (0 is the
+// first alphabetically), or past the last one if there are not that many. A rank a little ahead
+// of the current one is reached by stepping forward; any other is found from the prefix node by
+// skipping whole subtrees.
+void completionSeek(CompletionIterator &iterator, const PrefixCursor &cursor, size_t rank);
+
+// Moves the iterator to the next completion. Returns false once it is past the last one.
+bool completionNext(CompletionIterator &iterator);
+
+// True while the iterator is on a completion.
+inline bool completionValid(const CompletionIterator &iterator)
+{
+    return iterator.rank < iterator.total;
+}
+
+// Returns the rank `word` has among the completions of the cursor's prefix, found by summing the
+// word counts of the subtrees before its path. Only letters count, as in insert(); `word` must
+// start with the letters of the prefix. Returns false if it is not one of the completions.
+bool completionRank(const PrefixCursor &cursor, std::string_view word, size_t &rank);
+
+// Moves every word of the parts into `trie` and deletes the parts. None of them may have
+// compressed meanings. Their slabs and meaning chunks
+// are appended to the trie's arena and pool, so no word is inserted again; the handles inside each
+// part are rebased first, on one thread per part. No first letter may be used by more than one of
+// `trie` and the parts. A word without letters in a later part replaces an earlier one.
+void mergeTries(Trie *trie, std::vector<Trie *> &parts);
+
+// Removes a word from the trie, freeing the nodes only it used. Returns true if the word was present.
+bool remove(Trie *trie, const std::string &word);
+
+// Copy-on-write versions of insert() and remove(): the nodes on the word's path are copied, the
+// copies are changed, and the new root is published with one atomic store, so a query running on
+// another thread sees either the old trie or the new one. The replaced nodes are appended to
+// `retired`; they must stay untouched until no reader can still be on them, then be given to
+// freeRetiredNode(). Only one thread may modify the trie at a time. See VersionedTrie.
+void insertCopy(Trie *trie, std::string_view word, std::string_view meaning, std::vector<NodeRef> &retired);
+bool removeCopy(Trie *trie, const std::string &word, std::vector<NodeRef> &retired);
+void freeRetiredNode(Trie *trie, NodeRef ref);
 
-// Recursively removes a word from the trie.
-TrieNode *remove(TrieNode *root, const std::string &word);
+// Reports how much memory the trie's nodes and meanings use and reserve.
+TrieMemoryUsage getMemoryUsage(const Trie *trie);
 
-void deleteTrie(TrieNode *&root);
+// Deletes the whole trie by releasing its arena and meaning pool in one step each.
+void deleteTrie(Trie *&trie);
 
 #endif // TRIE_H
@@ -1,10 +1,15 @@
 #include "UI.h"
 #include "Trie.h" // Include trie functions and structure.
+#include "QueryWorker.h"
+#include "WriteAheadLog.h"
+#include "Metrics.h"
 #include <string>
 #include <vector>
-#include <fstream>
 #include <algorithm>
 #include <deque>
+#include <cstdio>
+#include <map>
+#include <tuple>
 
 // Global variables for screen dimensions and textures.
 static int screenWidth;
@@ -16,10 +21,140 @@ static Texture2D logoTexture; // Dictionary logo texture
 static Font sRegularFont;
 static Font sItalicFont;
 
+// The parts of each screen that never change (background, dimming, titles, field labels), drawn
+// once into render textures by InitUI() and then drawn as a single quad per frame.
+static RenderTexture2D homeLayer;
+static RenderTexture2D searchLayer;
+static RenderTexture2D addWordLayer;
+
+// Set by a screen whose next frame must be drawn without waiting for input: its state changed
+// after it was drawn, it is waiting for the query worker, or it shows live numbers. See EndFrame().
+static bool redrawPending = false;
+
 // These variables will store the search text and the displayed meaning.
 static std::string displayedMeaning = "";
 static std::string searchText = "";
 
+// Set when a word is added, so the search screen asks for fresh suggestions.
+static bool suggestionsStale = false;
+
+// Measures text once per font, size and string. Button labels are centred every frame they are
+// drawn, but their text hardly ever changes.
+static Vector2 MeasureTextCached(const Font &font, const char *text, float fontSize, float spacing)
+{
+    static std::map<std::tuple<const Font *, float, float, std::string>, Vector2> sizes;
+    auto key = std::make_tuple(&font, fontSize, spacing, std::string(text));
+    auto it = sizes.find(key);
+    if (it == sizes.end())
+        it = sizes.emplace(key, MeasureTextEx(font, text, fontSize, spacing)).first;
+    return it->second;
+}
+
+// Draws a label centred in a rectangle.
+static void DrawCenteredText(const Font &font, const char *text, Rectangle box, float fontSize, Color color)
+{
+    Vector2 size = MeasureTextCached(font, text, fontSize, 2);
+    DrawTextEx(font, text, (Vector2){box.x + box.width / 2 - size.x / 2, box.y + box.height / 2 - size.y / 2}, fontSize, 2, color);
+}
+
+// The dimmed background every screen starts from.
+static void PaintBackdrop()
+{
+    if (backgroundTexture.id > 0)
+        DrawTexture(backgroundTexture, 0, 0, WHITE);
+    else
+        ClearBackground(RAYWHITE);
+
+    DrawRectangle(0, 0, screenWidth, screenHeight, (Color){0, 0, 0, 90});
+}
+
+static void PaintHomeLayer()
+{
+    PaintBackdrop();
+
+    float logoScale = 0.3f;
+    if (logoTexture.id > 0)
+    {
+        DrawTextureEx(logoTexture, (Vector2){20, 20}, 0.0f, logoScale, WHITE);
+    }
+
+    const char *title = "Dictionary App";
+    float titleFontSize = 70.0f;
+    Vector2 titleSize = MeasureTextEx(sRegularFont, title, titleFontSize, 2);
+    DrawTextEx(sRegularFont, title,
+               (Vector2){screenWidth / 2 - titleSize.x / 2, 100},
+               titleFontSize, 2, DARKBLUE);
+
+    const char *intro = "Search for words and discover meanings";
+    float introFontSize = 35.0f;
+    Vector2 introSize = MeasureTextEx(sItalicFont, intro, introFontSize, 2);
+    DrawTextEx(sItalicFont, intro,
+               (Vector2){screenWidth / 2 - introSize.x / 2, 180},
+               introFontSize, 2, BLUE);
+}
+
+// The labels sit to the left of the input boxes drawn by DrawAddWordScreen().
+static void PaintAddWordLayer()
+{
+    PaintBackdrop();
+    DrawTextEx(sRegularFont, "Word:", (Vector2){120, 135}, 28.0f, 2, DARKBLUE);
+    DrawTextEx(sRegularFont, "Meaning:", (Vector2){90, 215}, 28.0f, 2, DARKBLUE);
+}
+
+// Paints a static layer into a new render texture.
+static RenderTexture2D RenderStaticLayer(void (*paint)())
+{
+    RenderTexture2D layer = LoadRenderTexture(screenWidth, screenHeight);
+    if (layer.id > 0)
+    {
+        BeginTextureMode(layer);
+        ClearBackground(BLACK);
+        paint();
+        EndTextureMode();
+    }
+    return layer;
+}
+
+// Draws a static layer over the whole window, or paints it directly if its render texture could
+// not be created. The translucent parts painted into the layer lowered its alpha even though its
+// colours are final, so it is drawn as premultiplied over black, which shows the colours exactly as
+// painted. Render textures are stored upside down, hence the negative height.
+static void DrawStaticLayer(const RenderTexture2D &layer, void (*paint)())
+{
+    if (layer.id == 0)
+    {
+        paint();
+        return;
+    }
+    ClearBackground(BLACK);
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(layer.texture, (Rectangle){0, 0, (float)layer.texture.width, -(float)layer.texture.height}, (Vector2){0, 0}, WHITE);
+    EndBlendMode();
+}
+
+// Ends a frame. Unless the screen asked for another frame, EndDrawing() then sleeps until the next
+// input event (raylib's event waiting), so an idle window uses no CPU; otherwise frames keep coming
+// at the target rate.
+static void EndFrame()
+{
+    static bool mayWait = false, mayWaitBefore = false; // Whether the last two frames were allowed to sleep
+
+    // The previous frame, including the wait for this one. Frames that may have slept until input
+    // are skipped, as their time is mostly idle; raylib counts the sleep in the frame that slept or
+    // in the one after it.
+    if (!mayWait && !mayWaitBefore)
+        METRICS_RECORD(METRIC_FRAME, uint64_t(GetFrameTime() * 1e9));
+
+    mayWaitBefore = mayWait;
+    mayWait = !redrawPending;
+    redrawPending = false;
+    if (mayWait)
+        EnableEventWaiting();
+    else
+        DisableEventWaiting();
+    EndDrawing();
+}
+
 /**
  * @brief Initializes the UI components including the window, fonts, and textures.
  *
@@ -42,18 +177,27 @@ void InitUI(int width, int height)
     // Load background and logo textures.
     backgroundTexture = LoadTexture("../assets/images/background.jpg");
     logoTexture = LoadTexture("../assets/images/logo.png");
+
+    // Paint the static part of each screen once.
+    homeLayer = RenderStaticLayer(PaintHomeLayer);
+    searchLayer = RenderStaticLayer(PaintBackdrop);
+    addWordLayer = RenderStaticLayer(PaintAddWordLayer);
 }
 
+
 /**
  * @brief Closes the UI by unloading textures, deleting the Trie, and closing the window.
  *
- * @param root Pointer to the root of the Trie.
+ * @param dictionary Pointer to the Trie dictionary.
  */
-void CloseUI(TrieNode *root)
+void CloseUI(Trie *dictionary)
 {
+    UnloadRenderTexture(homeLayer);
+    UnloadRenderTexture(searchLayer);
+    UnloadRenderTexture(addWordLayer);
     UnloadTexture(backgroundTexture);
     UnloadTexture(logoTexture);
-    deleteTrie(root);
+    deleteTrie(dictionary);
     CloseWindow();
 }
 
@@ -66,32 +210,7 @@ Screen DrawHomeScreen()
 {
     BeginDrawing();
 
-    if (backgroundTexture.id > 0)
-        DrawTexture(backgroundTexture, 0, 0, WHITE);
-    else
-        ClearBackground(RAYWHITE);
-
-    DrawRectangle(0, 0, screenWidth, screenHeight, (Color){0, 0, 0, 90});
-
-    float logoScale = 0.3f;
-    if (logoTexture.id > 0)
-    {
-        DrawTextureEx(logoTexture, (Vector2){20, 20}, 0.0f, logoScale, WHITE);
-    }
-
-    const char *title = "Dictionary App";
-    float titleFontSize = 70.0f;
-    Vector2 titleSize = MeasureTextEx(sRegularFont, title, titleFontSize, 2);
-    DrawTextEx(sRegularFont, title,
-               (Vector2){screenWidth / 2 - titleSize.x / 2, 100},
-               titleFontSize, 2, DARKBLUE);
-
-    const char *intro = "Search for words and discover meanings";
-    float introFontSize = 35.0f;
-    Vector2 introSize = MeasureTextEx(sItalicFont, intro, introFontSize, 2);
-    DrawTextEx(sItalicFont, intro,
-               (Vector2){screenWidth / 2 - introSize.x / 2, 180},
-               introFontSize, 2, BLUE);
+    DrawStaticLayer(homeLayer, PaintHomeLayer);
 
     // ----- Search Button -----
     Rectangle searchButton = {screenWidth / 2 - 110, screenHeight / 2 - 50, 220, 70};
@@ -102,17 +221,14 @@ Screen DrawHomeScreen()
         if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
         {
             displayedMeaning = "";
-            EndDrawing();
+            redrawPending = true; // Draw the search screen before waiting for input
+            EndFrame();
             return SEARCH;
         }
     }
     DrawRectangleRec(searchButton, searchButtonColor);
     DrawRectangleLinesEx(searchButton, 3, DARKBLUE);
-    Vector2 searchTextSize = MeasureTextEx(sRegularFont, "Search", 32.0f, 2);
-    DrawTextEx(sRegularFont, "Search",
-               (Vector2){searchButton.x + searchButton.width / 2 - searchTextSize.x / 2,
-                         searchButton.y + searchButton.height / 2 - searchTextSize.y / 2},
-               32.0f, 2, WHITE);
+    DrawCenteredText(sRegularFont, "Search", searchButton, 32.0f, WHITE);
 
     // ----- Add Word Button -----
     Rectangle addWordButton = {screenWidth / 2 - 110, screenHeight / 2 + 30, 220, 70};
@@ -122,55 +238,150 @@ Screen DrawHomeScreen()
         addWordButtonColor = DARKBLUE;
         if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
         {
-            EndDrawing();
+            redrawPending = true;
+            EndFrame();
             return ADDWORD;
         }
     }
 
     DrawRectangleRec(addWordButton, addWordButtonColor);
     DrawRectangleLinesEx(addWordButton, 3, DARKBLUE);
-    Vector2 addWordTextSize = MeasureTextEx(sRegularFont, "Add Word", 32.0f, 2);
-    DrawTextEx(sRegularFont, "Add Word",
-               (Vector2){addWordButton.x + addWordButton.width / 2 - addWordTextSize.x / 2,
-                         addWordButton.y + addWordButton.height / 2 - addWordTextSize.y / 2},
-               32.0f, 2, WHITE);
+    DrawCenteredText(sRegularFont, "Add Word", addWordButton, 32.0f, WHITE);
 
-    EndDrawing();
+    EndFrame();
     return HOME;
 }
 
+/**
+ * @brief Draws the performance overlay: frame time, the latency of the dictionary calls with
+ * their histograms, the dictionary's memory use, and how long each startup phase took.
+ * The numbers come from the metrics the app records with DICTIONARY_METRICS.
+ */
+static void DrawPerformanceOverlay()
+{
+    const float x = (float)screenWidth - 640, width = 620, lineHeight = 24, fontSize = 20;
+    float y = 270;
+    Rectangle panel = {x, y, width, 620};
+    DrawRectangleRec(panel, (Color){0, 0, 0, 200});
+    DrawRectangleLinesEx(panel, 2, GRAY);
+    char line[160];
+    y += 10;
+    auto text = [&](const char *content, Color color) {
+        DrawTextEx(sRegularFont, content, (Vector2){x + 12, y}, fontSize, 1, color);
+        y += lineHeight;
+    };
+
+    text("Performance (F3 to hide)", YELLOW);
+    if (!METRICS_ENABLED)
+    {
+        text("This build has no metrics (DICTIONARY_METRICS is off).", WHITE);
+        return;
+    }
+
+    MetricSnapshot frame = metricSnapshot(METRIC_FRAME);
+    std::snprintf(line, sizeof(line), "Frame: %.2f ms   p50 < %.1f ms   p99 < %.1f ms   max %.1f ms", frame.lastNs / 1e6,
+                  metricPercentileNs(frame, 0.5) / 1e6, metricPercentileNs(frame, 0.99) / 1e6, frame.maxNs / 1e6);
+    text(line, WHITE);
+    std::snprintf(line, sizeof(line), "Words %llu   nodes %llu   node bytes %.1f MiB   meaning bytes %.1f MiB",
+                  (unsigned long long)gaugeValue(GAUGE_WORD_COUNT), (unsigned long long)gaugeValue(GAUGE_NODE_COUNT),
+                  gaugeValue(GAUGE_NODE_BYTES) / 1048576.0, gaugeValue(GAUGE_MEANING_BYTES) / 1048576.0);
+    text(line, WHITE);
+
+    // One row per call: counts and times in microseconds, then its latency histogram from 64 ns
+    // (left) to 64 ms (right), each bar scaled to the row's fullest bucket.
+    y += 6;
+    text("call                 count     mean     last     p99   (us)", LIGHTGRAY);
+    const MetricId calls[] = {METRIC_GET_MEANING, METRIC_GET_MEANINGS, METRIC_GET_SUGGESTIONS, METRIC_GET_COMPLETIONS,
+                              METRIC_FUZZY_MATCHES, METRIC_DEFINITION_SEARCH, METRIC_QUERY_SUGGEST, METRIC_QUERY_LOOKUP, METRIC_QUERY_INSERT};
+    const int firstBucket = 6, lastBucket = 26;
+    for (MetricId id : calls)
+    {
+        MetricSnapshot m = metricSnapshot(id);
+        double mean = m.count > 0 ? m.totalNs / 1e3 / m.count : 0;
+        std::snprintf(line, sizeof(line), "%-18s %7llu %8.1f %8.1f %7.0f", metricName(id), (unsigned long long)m.count, mean,
+                      m.lastNs / 1e3, metricPercentileNs(m, 0.99) / 1e3);
+        DrawTextEx(sRegularFont, line, (Vector2){x + 12, y}, fontSize, 1, WHITE);
+
+        uint64_t fullest = 1;
+        for (int b = firstBucket; b <= lastBucket; b++)
+            fullest = std::max(fullest, m.buckets[b]);
+        for (int b = firstBucket; b <= lastBucket; b++)
+        {
+            float barHeight = (lineHeight - 6) * float(m.buckets[b]) / float(fullest);
+            DrawRectangle(int(x + 430 + (b - firstBucket) * 8), int(y + lineHeight - 4 - barHeight), 6, int(barHeight) + 1,
+                          m.buckets[b] > 0 ? SKYBLUE : DARKGRAY);
+        }
+        y += lineHeight;
+    }
+
+    y += 6;
+    text("Startup (ms)", LIGHTGRAY);
+    const MetricId phases[] = {METRIC_LOAD_IMAGE, METRIC_LOAD_TEXT, METRIC_LOAD_WRITE_IMAGE, METRIC_LOAD_COMPRESS,
+                               METRIC_LOAD_REPLAY_LOG, METRIC_LOAD_INDEX, METRIC_LOAD_RANKER, METRIC_LOAD_FREEZE};
+    for (MetricId id : phases)
+    {
+        MetricSnapshot m = metricSnapshot(id);
+        if (m.count == 0)
+            continue; // The phase did not run, e.g. no text load when the image was usable
+        std::snprintf(line, sizeof(line), "%-18s %9.2f", metricName(id), m.lastNs / 1e6);
+        text(line, WHITE);
+    }
+}
+
+// The line listing the recent searches.
+static std::string RecentLine(const std::deque<std::string> &recentWords)
+{
+    std::string line = "Recent: ";
+    for (size_t i = 0; i < recentWords.size(); i++)
+    {
+        line += recentWords[i];
+        if (i < recentWords.size() - 1)
+            line += ", ";
+    }
+    return line;
+}
+
+// The line telling which of the matches are shown, or an empty string when every match is shown.
+static std::string MoreMatchesLine(size_t totalMatches, size_t firstRow, size_t shown)
+{
+    if (totalMatches <= shown)
+        return std::string();
+    return std::to_string(firstRow + 1) + "-" + std::to_string(firstRow + shown) + " of " + std::to_string(totalMatches) +
+           " matches, scroll for more";
+}
+
 /**
  * @brief Renders the search screen where users can search for words, view meanings,
  * suggestions, and recent searches.
  *
- * @param dictionary Pointer to the Trie dictionary.
+ * @param queries Worker that runs the dictionary queries; the screen posts requests and draws
+ *                whatever answers have arrived, so a slow query never holds up a frame.
+ * @param log     Log that saves the recent searches in the background.
  * @return true if the back button is pressed, false otherwise.
  */
-bool DrawSearchScreen(TrieNode *dictionary)
+bool DrawSearchScreen(QueryWorker *queries, WriteAheadLog *log)
 {
     static std::deque<std::string> recentWords; // Stores up to 5 recent words
+    static std::string recentDisplay;           // "Recent: ..." line, rebuilt only when the words change
+    static bool searchDefinitions = false;      // "Meanings" mode: find words by the text of their definitions
+    static size_t partOfSpeechFilter = 0;       // Index into the filters below; 0 shows every word
+    static bool showPerformance = false;        // F3 toggles the performance overlay
 
-    // Load recent searches from "recent.txt" (only once at startup)
-    if (recentWords.empty())
+    const uint8_t partOfSpeechFilters[] = {POS_ANY, POS_NOUN, POS_VERB, POS_ADJECTIVE, POS_ADVERB,
+                                           POS_PRONOUN, POS_PREPOSITION, POS_CONJUNCTION, POS_OTHER};
+
+    // Take the recent searches the log read at startup (only once)
+    static bool recentLoaded = false;
+    if (!recentLoaded)
     {
-        std::ifstream recentFile("recent.txt");
-        std::string word;
-        while (std::getline(recentFile, word, ','))
-        {
-            if (!word.empty())
-                recentWords.push_back(word);
-        }
-        recentFile.close();
+        recentWords.assign(log->recentWords().begin(), log->recentWords().end());
+        recentDisplay = RecentLine(recentWords);
+        recentLoaded = true;
     }
 
     BeginDrawing();
 
-    if (backgroundTexture.id > 0)
-        DrawTexture(backgroundTexture, 0, 0, WHITE);
-    else
-        ClearBackground(RAYWHITE);
-
-    DrawRectangle(0, 0, screenWidth, screenHeight, (Color){0, 0, 0, 90});
+    DrawStaticLayer(searchLayer, PaintBackdrop);
 
     // ----- Back Button -----
     Rectangle backButton = {20, 20, 120, 50};
@@ -182,17 +393,14 @@ bool DrawSearchScreen(TrieNode *dictionary)
         {
             searchText = "";
             displayedMeaning = "";
-            EndDrawing();
+            redrawPending = true; // Draw the home screen before waiting for input
+            EndFrame();
             return true;
         }
     }
     DrawRectangleRec(backButton, backButtonColor);
     DrawRectangleLinesEx(backButton, 3, DARKBLUE);
-    Vector2 backTextSize = MeasureTextEx(sRegularFont, "<- Back", 28.0f, 2);
-    DrawTextEx(sRegularFont, "<- Back",
-               (Vector2){backButton.x + backButton.width / 2 - backTextSize.x / 2,
-                         backButton.y + backButton.height / 2 - backTextSize.y / 2},
-               28.0f, 2, WHITE);
+    DrawCenteredText(sRegularFont, "<- Back", backButton, 28.0f, WHITE);
 
     // ----- Search Bar -----
     Rectangle searchBar = {100, 120, screenWidth - 320, 60};
@@ -202,13 +410,54 @@ bool DrawSearchScreen(TrieNode *dictionary)
                (Vector2){searchBar.x + 20, searchBar.y + 15},
                28.0f, 2, BLACK);
 
+    // ----- Mode Button: search words or meanings -----
+    Rectangle modeButton = {(float)screenWidth - 200, 120, 180, 60};
+    Color modeButtonColor = searchDefinitions ? DARKBLUE : BLUE;
+    if (CheckCollisionPointRec(GetMousePosition(), modeButton))
+    {
+        modeButtonColor = DARKBLUE;
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+        {
+            searchDefinitions = !searchDefinitions;
+            displayedMeaning = "";
+            redrawPending = true;
+        }
+    }
+    const char *modeText = searchDefinitions ? "Meanings" : "Words";
+    DrawRectangleRec(modeButton, modeButtonColor);
+    DrawRectangleLinesEx(modeButton, 3, WHITE);
+    DrawCenteredText(sRegularFont, modeText, modeButton, 28.0f, WHITE);
+
+    // ----- Part of Speech Filter Button: cycles through the filters (Words mode only) -----
+    if (!searchDefinitions)
+    {
+        Rectangle filterButton = {(float)screenWidth - 200, 200, 180, 50};
+        Color filterButtonColor = partOfSpeechFilter != 0 ? DARKBLUE : BLUE;
+        if (CheckCollisionPointRec(GetMousePosition(), filterButton))
+        {
+            filterButtonColor = DARKBLUE;
+            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+            {
+                partOfSpeechFilter = (partOfSpeechFilter + 1) % (sizeof(partOfSpeechFilters) / sizeof(partOfSpeechFilters[0]));
+                redrawPending = true;
+            }
+        }
+        uint8_t filter = partOfSpeechFilters[partOfSpeechFilter];
+        const char *filterText = filter == POS_ANY ? "All" : partOfSpeechName(PartOfSpeech(filter));
+        DrawRectangleRec(filterButton, filterButtonColor);
+        DrawRectangleLinesEx(filterButton, 3, WHITE);
+        DrawCenteredText(sRegularFont, filterText, filterButton, 24.0f, WHITE);
+    }
+
     // ----- Process Text Input -----
+    // The search bar was drawn before the keys were read, so a change is shown on the next frame.
     int key = GetCharPressed();
     while (key > 0)
     {
         if (key >= 32 && key <= 125)
         {
             searchText += (char)key;
+            redrawPending = true;
         }
         key = GetCharPressed();
     }
@@ -216,62 +465,192 @@ bool DrawSearchScreen(TrieNode *dictionary)
     {
         searchText.pop_back();
         displayedMeaning = ""; // Clear displayed meaning when backspace is pressed.
+        redrawPending = true;
     }
 
-    // ----- Perform Search on ENTER Key Press -----
-    if (IsKeyPressed(KEY_ENTER) && !searchText.empty())
+    // ----- Scroll the Suggestion List -----
+    // The list is virtual: only the rows on screen are ever fetched, so scrolling through all the
+    // words of a one-letter prefix costs the same per frame as showing the first few. Only the
+    // unfiltered Words list knows its length and can be scrolled.
+    const size_t maxSuggestions = 6;
+    static size_t firstRow = 0;     // Row of the list at the top of the screen
+    static size_t totalMatches = 0;
+    bool scrollable = !searchDefinitions && partOfSpeechFilters[partOfSpeechFilter] == POS_ANY && totalMatches > maxSuggestions;
+    if (scrollable)
     {
-        std::string meaningFound = getMeaning(dictionary, searchText);
-        if (!meaningFound.empty())
+        long long row = (long long)firstRow;
+        row -= (long long)(GetMouseWheelMove() * 3);
+        if (IsKeyPressed(KEY_DOWN))
+            row++;
+        if (IsKeyPressed(KEY_UP))
+            row--;
+        if (IsKeyPressed(KEY_PAGE_DOWN))
+            row += maxSuggestions;
+        if (IsKeyPressed(KEY_PAGE_UP))
+            row -= maxSuggestions;
+        row = std::max(0LL, std::min(row, (long long)(totalMatches - maxSuggestions)));
+        if ((size_t)row != firstRow)
         {
-            displayedMeaning = "Meaning: " + meaningFound;
+            firstRow = (size_t)row;
+            redrawPending = true;
         }
-        else
+    }
+
+    // ----- Collect Answers from the Query Worker -----
+    // Only the answer to the newest request of each kind is used; older ones are for text that has
+    // changed since. While an answer is awaited the screen keeps drawing frames, as its arrival is
+    // not an input event that would wake the window.
+    static std::vector<std::string> suggestions;
+    static size_t shownRow = 0;     // Row of the list the suggestions on screen start at
+    static std::string moreMatches; // "1-6 of N matches" line, rebuilt only when the suggestions change
+    static uint64_t suggestSequence = 0, lookupSequence = 0;
+    static bool awaitingSuggestions = false, awaitingLookup = false;
+    static bool lookupInDefinitions = false;
+    QueryResult result;
+    while (queries->poll(result))
+    {
+        if (result.kind == QUERY_SUGGEST && result.sequence == suggestSequence)
         {
-            displayedMeaning = "Word not found.";
+            suggestions = std::move(result.words);
+            totalMatches = result.totalMatches;
+            shownRow = result.offset;
+            moreMatches = MoreMatchesLine(totalMatches, shownRow, suggestions.size());
+            awaitingSuggestions = false;
         }
+        else if (result.kind == QUERY_LOOKUP && result.sequence == lookupSequence && lookupInDefinitions)
+        {
+            awaitingLookup = false;
+            // In "Meanings" mode, show the meaning of the first word whose definition matches.
+            if (!result.meaning.empty())
+                displayedMeaning = result.word + ": " + result.meaning;
+            else
+                displayedMeaning = "No meaning contains all of these words.";
+        }
+        else if (result.kind == QUERY_LOOKUP && result.sequence == lookupSequence)
+        {
+            awaitingLookup = false;
+            if (!result.meaning.empty())
+            {
+                displayedMeaning = "Meaning: " + result.meaning;
+                suggestionsStale = true; // The lookup raised the word's rank
+            }
+            else
+            {
+                // Offer the closest spellings.
+                displayedMeaning = "Word not found.";
+                for (size_t i = 0; i < result.words.size(); i++)
+                    displayedMeaning += (i == 0 ? " Did you mean: " : ", ") + result.words[i];
+                if (!result.words.empty())
+                    displayedMeaning += "?";
+            }
+        }
+    }
 
+    // ----- Perform Search on ENTER Key Press -----
+    if (IsKeyPressed(KEY_ENTER) && !searchText.empty())
+    {
+        QueryRequest lookup;
+        lookup.kind = QUERY_LOOKUP;
+        lookup.definitions = searchDefinitions;
+        lookup.limit = 5;
+        lookup.text = searchText;
+        lookupSequence = queries->post(lookup);
+        awaitingLookup = lookupSequence != 0;
+        lookupInDefinitions = searchDefinitions;
+        displayedMeaning = lookupSequence != 0 ? "Searching..." : "Busy, press Enter again.";
+    }
+    if (IsKeyPressed(KEY_ENTER) && !searchText.empty() && !searchDefinitions)
+    {
         // ---- Store Recent Searches -----
         if (std::find(recentWords.begin(), recentWords.end(), searchText) == recentWords.end())
         {
-            if (recentWords.size() >= 5)
+            if (recentWords.size() >= WriteAheadLog::MAX_RECENT_WORDS)
             {
                 recentWords.pop_front();
             }
             recentWords.push_back(searchText);
-
-            std::ofstream recentFile("recent.txt", std::ios::trunc);
-            for (size_t i = 0; i < recentWords.size(); i++)
-            {
-                recentFile << recentWords[i];
-                if (i < recentWords.size() - 1)
-                    recentFile << ",";
-            }
-            recentFile.close();
+            recentDisplay = RecentLine(recentWords);
+            log->setRecentWords(std::vector<std::string>(recentWords.begin(), recentWords.end()));
         }
     }
 
-    // ----- Compute Suggestions Based on Search Text -----
-    std::vector<std::pair<std::string, std::string>> suggestions;
-    if (!searchText.empty())
+    // ----- Request Suggestions Based on Search Text -----
+    // A request is only posted when the text, mode or filter changes, the list is scrolled, or a
+    // word was added or ranked up; on an unchanged frame no query work is done at all. The previous
+    // suggestions stay on screen until the new ones arrive. If the queue is full, the request is
+    // retried on the next frame.
+    static std::string requestedText;
+    static bool requestedDefinitions = false;
+    static uint8_t requestedFilter = POS_ANY;
+    static size_t requestedRow = 0;
+    uint8_t filter = partOfSpeechFilters[partOfSpeechFilter];
+    if (requestedText != searchText || requestedDefinitions != searchDefinitions || requestedFilter != filter)
+        firstRow = 0; // A new list starts at its top
+    if (requestedText != searchText || requestedDefinitions != searchDefinitions || requestedFilter != filter ||
+        requestedRow != firstRow || suggestionsStale)
     {
-        suggestions = getSuggestions(dictionary, searchText);
+        uint64_t sequence = 0;
+        if (!searchText.empty())
+        {
+            QueryRequest suggest;
+            suggest.kind = QUERY_SUGGEST;
+            suggest.definitions = searchDefinitions;
+            suggest.partsOfSpeech = filter;
+            suggest.limit = maxSuggestions;
+            suggest.offset = firstRow;
+            suggest.text = searchText;
+            sequence = queries->post(suggest);
+        }
+        else
+        {
+            suggestions.clear();
+            totalMatches = 0;
+            shownRow = 0;
+            moreMatches.clear();
+        }
+        suggestSequence = sequence; // Any answer still on its way is for older text
+        awaitingSuggestions = sequence != 0;
+        if (sequence != 0 || searchText.empty())
+        {
+            requestedText = searchText;
+            requestedDefinitions = searchDefinitions;
+            requestedFilter = filter;
+            requestedRow = firstRow;
+            suggestionsStale = false;
+        }
+        else
+            redrawPending = true; // Retry on the next frame
     }
+    if (awaitingSuggestions || awaitingLookup)
+        redrawPending = true;
 
-    // ----- Draw Suggestions (Limit to 6) -----
+    // ----- Draw Suggestions (the 6 rows on screen) -----
     int suggestionY = 200;
-    DrawTextEx(sRegularFont, "Suggestions:", (Vector2){100, (float)suggestionY}, 30.0f, 2, DARKBLUE);
+    const char *suggestionsTitle = searchDefinitions ? "Words whose meaning contains this:" : "Suggestions:";
+    DrawTextEx(sRegularFont, suggestionsTitle, (Vector2){100, (float)suggestionY}, 30.0f, 2, DARKBLUE);
     suggestionY += 50;
-    int count = 0;
-    for (const auto &suggestion : suggestions)
+    if (scrollable)
     {
-        if (count >= 6)
-            break;
-        DrawTextEx(sRegularFont, suggestion.first.c_str(),
+        // Scroll bar to the right of the rows, its thumb sized and placed by the rows on screen.
+        Rectangle track = {(float)screenWidth - 240, (float)suggestionY, 8, 50.0f * maxSuggestions};
+        float thumbHeight = std::max(20.0f, track.height * maxSuggestions / totalMatches);
+        float thumbY = track.y + (track.height - thumbHeight) * std::min(shownRow, totalMatches - maxSuggestions) / (totalMatches - maxSuggestions);
+        DrawRectangleRec(track, (Color){230, 230, 230, 160});
+        DrawRectangleRec((Rectangle){track.x, thumbY, track.width, thumbHeight}, DARKBLUE);
+    }
+    for (const std::string &suggestion : suggestions)
+    {
+        DrawTextEx(sRegularFont, suggestion.c_str(),
                    (Vector2){100, (float)suggestionY},
                    28.0f, 2, BLACK);
         suggestionY += 50;
-        count++;
+    }
+    if (!moreMatches.empty())
+    {
+        DrawTextEx(sItalicFont, moreMatches.c_str(),
+                   (Vector2){100, (float)suggestionY},
+                   24.0f, 2, DARKGRAY);
+        suggestionY += 40;
     }
 
     // ----- Display Meaning Panel (if available) -----
@@ -288,14 +667,6 @@ bool DrawSearchScreen(TrieNode *dictionary)
     // ----- Display Recent Searches at Bottom -----
     if (!recentWords.empty())
     {
-        std::string recentDisplay = "Recent: ";
-        for (size_t i = 0; i < recentWords.size(); i++)
-        {
-            recentDisplay += recentWords[i];
-            if (i < recentWords.size() - 1)
-                recentDisplay += ", ";
-        }
-
         int recentY = screenHeight - 70;
         int boxHeight = 50;
         int boxWidth = screenWidth - 200;
@@ -308,19 +679,28 @@ bool DrawSearchScreen(TrieNode *dictionary)
                    (Vector2){120, (float)recentY}, 32.0f, 2, BLACK);
     }
 
-    EndDrawing();
+    // ----- Performance Overlay -----
+    // While it is shown, frames are drawn continuously so its numbers stay live.
+    if (IsKeyPressed(KEY_F3))
+        showPerformance = !showPerformance;
+    if (showPerformance)
+    {
+        DrawPerformanceOverlay();
+        redrawPending = true;
+    }
+
+    EndFrame();
     return false;
 }
 
 /**
  * @brief Renders the Add Word screen where users can insert new words and their meanings.
  *
- * @param dictionary     Pointer to the Trie dictionary.
- * @param wordFilename   Filename for storing words.
- * @param meaningFilename Filename for storing meanings.
+ * @param queries Worker that owns the dictionary; the word is added through it.
+ * @param log     Log that saves the word and its meaning in the background.
  * @return true if the back button is pressed, false otherwise.
  */
-bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, const std::string &meaningFilename)
+bool DrawAddWordScreen(QueryWorker *queries, WriteAheadLog *log)
 {
     static std::string wordInput = "";
     static std::string meaningInput = "";
@@ -328,12 +708,7 @@ bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, co
 
     BeginDrawing();
 
-    if (backgroundTexture.id > 0)
-        DrawTexture(backgroundTexture, 0, 0, WHITE);
-    else
-        ClearBackground(RAYWHITE);
-
-    DrawRectangle(0, 0, screenWidth, screenHeight, (Color){0, 0, 0, 90});
+    DrawStaticLayer(addWordLayer, PaintAddWordLayer);
 
     // ----- Back Button -----
     Rectangle backButton = {20, 20, 120, 50};
@@ -345,25 +720,20 @@ bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, co
         {
             searchText = "";
             displayedMeaning = "";
-            EndDrawing();
+            redrawPending = true; // Draw the home screen before waiting for input
+            EndFrame();
             return true;
         }
     }
     DrawRectangleRec(backButton, backButtonColor);
     DrawRectangleLinesEx(backButton, 3, DARKBLUE);
-    Vector2 backTextSize = MeasureTextEx(sRegularFont, "<- Back", 28.0f, 2);
-    DrawTextEx(sRegularFont, "<- Back",
-               (Vector2){backButton.x + backButton.width / 2 - backTextSize.x / 2,
-                         backButton.y + backButton.height / 2 - backTextSize.y / 2},
-               28.0f, 2, WHITE);
+    DrawCenteredText(sRegularFont, "<- Back", backButton, 28.0f, WHITE);
 
     // ----- Word Input Box -----
     Rectangle wordBox = {200, 120, screenWidth - 420, 60};
     Color wordBoxColor = (activeField == 1) ? LIGHTGRAY : (Color){245, 245, 245, 255};
     DrawRectangleRec(wordBox, wordBoxColor);
     DrawRectangleLinesEx(wordBox, 3, DARKBLUE);
-    DrawTextEx(sRegularFont, "Word:",
-               (Vector2){wordBox.x - 80, wordBox.y + 15}, 28.0f, 2, DARKBLUE);
     DrawTextEx(sRegularFont, wordInput.c_str(),
                (Vector2){wordBox.x + 20, wordBox.y + 15}, 28.0f, 2, BLACK);
 
@@ -372,14 +742,15 @@ bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, co
     Color meaningBoxColor = (activeField == 2) ? LIGHTGRAY : (Color){245, 245, 245, 255};
     DrawRectangleRec(meaningBox, meaningBoxColor);
     DrawRectangleLinesEx(meaningBox, 3, DARKBLUE);
-    DrawTextEx(sRegularFont, "Meaning:",
-               (Vector2){meaningBox.x - 110, meaningBox.y + 15}, 28.0f, 2, DARKBLUE);
     DrawTextEx(sRegularFont, meaningInput.c_str(),
                (Vector2){meaningBox.x + 20, meaningBox.y + 15}, 28.0f, 2, BLACK);
 
     // ----- Handle Mouse Clicks for Switching Active Field -----
+    // The boxes and their text were drawn before the input was read, so changes are shown on the
+    // next frame.
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
     {
+        redrawPending = true;
         Vector2 mousePos = GetMousePosition();
         if (CheckCollisionPointRec(mousePos, wordBox))
             activeField = 1;
@@ -399,12 +770,14 @@ bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, co
                 wordInput.push_back((char)key);
             else if (activeField == 2)
                 meaningInput.push_back((char)key);
+            redrawPending = true;
         }
         key = GetCharPressed();
     }
 
     if (IsKeyPressed(KEY_BACKSPACE))
     {
+        redrawPending = true;
         if (activeField == 1 && !wordInput.empty())
             wordInput.pop_back();
         else if (activeField == 2 && !meaningInput.empty())
@@ -419,19 +792,14 @@ bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, co
     if (CheckCollisionPointRec(GetMousePosition(), insertButton))
     {
         insertButtonColor = DARKBLUE;
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+        QueryRequest add;
+        add.kind = QUERY_INSERT;
+        add.text = wordInput;
+        add.meaning = meaningInput;
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && queries->post(add) != 0)
         {
-            insert(dictionary, wordInput, meaningInput);
-
-            std::ofstream wordFile(wordFilename, std::ios::app);
-            std::ofstream meaningFile(meaningFilename, std::ios::app);
-            if (wordFile.is_open() && meaningFile.is_open())
-            {
-                wordFile << wordInput << "\n";
-                meaningFile << meaningInput << "\n";
-            }
-            wordFile.close();
-            meaningFile.close();
+            suggestionsStale = true;
+            log->addWord(wordInput, meaningInput);
 
             wordInput.clear();
             meaningInput.clear();
@@ -440,12 +808,8 @@ bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, co
 
     DrawRectangleRec(insertButton, insertButtonColor);
     DrawRectangleLinesEx(insertButton, 3, WHITE);
-    Vector2 insertTextSize = MeasureTextEx(sRegularFont, "Insert", 28.0f, 2);
-    DrawTextEx(sRegularFont, "Insert",
-               (Vector2){insertButton.x + insertButton.width / 2 - insertTextSize.x / 2,
-                         insertButton.y + insertButton.height / 2 - insertTextSize.y / 2},
-               28.0f, 2, insertTextColor);
+    DrawCenteredText(sRegularFont, "Insert", insertButton, 28.0f, insertTextColor);
 
-    EndDrawing();
+    EndFrame();
     return false;
 }
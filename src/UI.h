@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 #include "Trie.h"
+#include "QueryWorker.h"
+#include "WriteAheadLog.h"
 
 // Enum for different screens in the UI.
 enum Screen
@@ -18,7 +20,7 @@ enum Screen
 void InitUI(int width, int height);
 
 // Unloads resources and closes the window, including freeing up memory used by the Trie.
-void CloseUI(TrieNode *root);
+void CloseUI(Trie *dictionary);
 
 // Draws the home screen UI. Returns the screen the user wishes to navigate to,
 // based on button clicks (e.g., "Search" or "Add Word").
@@ -26,12 +28,16 @@ Screen DrawHomeScreen();
 
 // Draws the search screen UI, where the user can search for a word. This function
 // also updates the search text, shows suggestions based on the input, and displays
-// the meaning of the word. Returns true if the "Back" button is pressed.
-bool DrawSearchScreen(TrieNode *dictionary);
+// the meaning of the word. The queries run on the worker and their answers are drawn once they
+// arrive. Suggestions are ranked, and a word that is found ranks higher afterwards. In
+// "Meanings" mode the text is looked up in the definitions instead. The recent searches are
+// saved through the log. Returns true if the "Back" button is pressed.
+bool DrawSearchScreen(QueryWorker *queries, WriteAheadLog *log);
 
 // Draws the "Add Word" screen, allowing users to add a new word along with its meaning
-// to the dictionary. This function takes the filenames for words and meanings to
-// load the data accordingly.
-bool DrawAddWordScreen(TrieNode *dictionary, const std::string &wordFilename, const std::string &meaningFilename);
+// to the dictionary. The word is added by the query worker, which also adds it to the
+// definition index, and saved through the log, which later appends it to the word and meaning
+// files.
+bool DrawAddWordScreen(QueryWorker *queries, WriteAheadLog *log);
 
 #endif // UI_H
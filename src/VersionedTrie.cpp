@@ -0,0 +1,101 @@
+#include "VersionedTrie.h"
+#include <thread>
+
+VersionedTrie::Reader::Reader(VersionedTrie &owner)
+    : owner(owner), slot(0)
+{
+    while (true)
+    {
+        for (slot = 0; slot < MAX_READERS; slot++)
+        {
+            bool expected = false;
+            if (owner.slots[slot].claimed.compare_exchange_strong(expected, true))
+                return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+VersionedTrie::Reader::~Reader()
+{
+    owner.slots[slot].epoch.store(0);
+    owner.slots[slot].claimed.store(false);
+}
+
+// The epoch is stored before the root is loaded by the queries that follow, both sequentially
+// consistent: a writer scanning the slots after publishing a root either sees this pin, and keeps
+// the old nodes, or the queries see the new root and never reach the old nodes.
+void VersionedTrie::Reader::pin()
+{
+    owner.slots[slot].epoch.store(owner.epoch.load());
+}
+
+void VersionedTrie::Reader::unpin()
+{
+    owner.slots[slot].epoch.store(0, std::memory_order_release);
+}
+
+// The arena's slab table and the pool's chunk table are sized for their limits, so a writer
+// adding a slab or chunk never moves a table a reader is indexing.
+VersionedTrie::VersionedTrie(Trie *trie)
+    : trie(trie)
+{
+    trie->nodes.reserveSlabTable();
+    trie->meanings.reserveChunkTable();
+}
+
+VersionedTrie::~VersionedTrie()
+{
+    for (const std::pair<uint64_t, NodeRef> &node : retired)
+        freeRetiredNode(trie, node.second);
+}
+
+void VersionedTrie::insert(std::string_view word, std::string_view meaning)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    insertCopy(trie, word, meaning, replaced);
+    retire();
+}
+
+bool VersionedTrie::remove(const std::string &word)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    bool removed = removeCopy(trie, word, replaced);
+    retire();
+    return removed;
+}
+
+size_t VersionedTrie::retiredCount()
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return retired.size();
+}
+
+// Tags the replaced nodes with the epoch the change was published in, then starts a new epoch.
+void VersionedTrie::retire()
+{
+    if (replaced.empty())
+        return;
+    uint64_t current = epoch.fetch_add(1);
+    for (NodeRef ref : replaced)
+        retired.emplace_back(current, ref);
+    replaced.clear();
+    reclaim();
+}
+
+// Frees the retired nodes older than every pinned reader.
+void VersionedTrie::reclaim()
+{
+    uint64_t oldest = epoch.load();
+    for (const ReaderSlot &slot : slots)
+    {
+        uint64_t pinned = slot.epoch.load();
+        if (pinned != 0 && pinned < oldest)
+            oldest = pinned;
+    }
+    while (!retired.empty() && retired.front().first < oldest)
+    {
+        freeRetiredNode(trie, retired.front().second);
+        retired.pop_front();
+    }
+}
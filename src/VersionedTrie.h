@@ -0,0 +1,105 @@
+#ifndef VERSIONED_TRIE_H
+#define VERSIONED_TRIE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Trie.h"
+
+// Lets any number of threads query a trie while another thread keeps changing it. Changes are
+// made with insertCopy()/removeCopy(): each one copies the nodes on its path and publishes a new
+// root, so a reader never sees a node being changed and never takes a lock. Readers use the
+// trie's usual query functions between pin() and unpin() (or inside a Pin), which hold back the
+// reuse of the nodes they might be walking:
+//
+// Epoch-based reclamation. A global epoch goes up after every change, and the nodes that change
+// replaced are retired with the epoch it happened in. pin() copies the current epoch into the
+// reader's slot. A node retired in epoch E can only be reached by readers pinned at E or earlier,
+// so it is freed once every pinned reader shows a later epoch. Readers write only their own slot,
+// which has a cache line to itself, so they never contend with each other.
+//
+// Query results copied out during a pin stay valid afterwards; meanings live in the append-only
+// pool and stay valid until the trie is deleted. Node pointers (including a PrefixCursor's path)
+// must not be kept past unpin(): seek cursors again after pinning.
+class VersionedTrie
+{
+public:
+    static constexpr size_t MAX_READERS = 64;
+
+    // A reader thread's slot. Each thread that queries the trie creates one and keeps it.
+    class Reader
+    {
+    public:
+        // Claims a free slot, waiting for one if MAX_READERS readers already exist.
+        explicit Reader(VersionedTrie &owner);
+        ~Reader();
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // Marks the start and the end of a set of queries. Pins do not nest.
+        void pin();
+        void unpin();
+
+        const Trie *trie() const { return owner.trie; }
+
+    private:
+        VersionedTrie &owner;
+        size_t slot;
+    };
+
+    // Pins a reader for as long as it is in scope.
+    class Pin
+    {
+    public:
+        explicit Pin(Reader &reader) : reader(reader) { reader.pin(); }
+        ~Pin() { reader.unpin(); }
+
+        Pin(const Pin &) = delete;
+        Pin &operator=(const Pin &) = delete;
+
+    private:
+        Reader &reader;
+    };
+
+    // The trie stays owned by the caller and must only be changed through this object from now
+    // on. No reader may be left when it is destroyed.
+    explicit VersionedTrie(Trie *trie);
+    ~VersionedTrie();
+
+    VersionedTrie(const VersionedTrie &) = delete;
+    VersionedTrie &operator=(const VersionedTrie &) = delete;
+
+    // Changes to the trie, from any thread; writers take turns on a mutex. Readers are not blocked.
+    void insert(std::string_view word, std::string_view meaning);
+    bool remove(const std::string &word);
+
+    // Nodes retired but not yet freed because a reader may still be on them.
+    size_t retiredCount();
+
+private:
+    // A reader's slot: the epoch it is pinned at, or 0 when it is not pinned.
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> claimed{false};
+    };
+
+    void retire();
+    void reclaim();
+
+    Trie *trie;
+    ReaderSlot slots[MAX_READERS];
+    alignas(64) std::atomic<uint64_t> epoch{1};
+
+    std::mutex writeMutex;                            // Held by the writer; readers never take it
+    std::vector<NodeRef> replaced;                    // Nodes replaced by the current change
+    std::deque<std::pair<uint64_t, NodeRef>> retired; // Retired nodes with their epoch, oldest first
+};
+
+#endif // VERSIONED_TRIE_H
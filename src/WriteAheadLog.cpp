@@ -0,0 +1,389 @@
+#include "WriteAheadLog.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Fixed-size header at the start of the log, followed by the records. Each record is a uint32
+// payload length, the uint32 CRC-32 of its type and payload, a one-byte type, and the payload.
+struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t wordsSize;    // Size of the word file the records apply to
+    uint64_t meaningsSize; // Size of the meaning file the records apply to
+};
+
+enum LogRecordType : uint8_t {
+    RECORD_WORD = 1,  // uint32 word length, the word, then the meaning
+    RECORD_RECENT = 2 // The recent searches, separated by commas, as in recent.txt
+};
+
+struct LogRecord {
+    LogRecordType type;
+    std::string_view payload;
+};
+
+static const char LOG_MAGIC[8] = {'G', 'D', 'I', 'C', 'T', 'W', 'A', 'L'};
+static const uint32_t LOG_VERSION = 1;
+static const size_t RECORD_HEADER_SIZE = 9;
+
+// The usual reflected CRC-32 (polynomial 0xEDB88320), a byte at a time from a table. Passing the
+// previous result as `crc` continues the checksum over another piece.
+static uint32_t crc32(const char *data, size_t size, uint32_t crc = 0)
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++)
+                value = (value >> 1) ^ (value & 1 ? 0xEDB88320u : 0);
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ uint8_t(data[i])) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void appendRecord(std::string &out, LogRecordType type, std::string_view payload)
+{
+    char typeByte = char(type);
+    uint32_t length = uint32_t(payload.size());
+    uint32_t crc = crc32(payload.data(), payload.size(), crc32(&typeByte, 1));
+    out.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    out.append(reinterpret_cast<const char *>(&crc), sizeof(crc));
+    out.push_back(typeByte);
+    out.append(payload);
+}
+
+// Collects the records after the header, stopping at the first that is cut short or fails its
+// CRC. Returns where the last intact record ends.
+static size_t parseRecords(std::string_view log, std::vector<LogRecord> &records)
+{
+    size_t pos = sizeof(LogHeader);
+    while (pos + RECORD_HEADER_SIZE <= log.size())
+    {
+        uint32_t length, crc;
+        std::memcpy(&length, log.data() + pos, sizeof(length));
+        std::memcpy(&crc, log.data() + pos + 4, sizeof(crc));
+        if (length > log.size() - pos - RECORD_HEADER_SIZE)
+            break;
+        std::string_view body = log.substr(pos + 8, 1 + length);
+        if (crc32(body.data(), body.size()) != crc)
+            break;
+        records.push_back(LogRecord{LogRecordType(body[0]), body.substr(1)});
+        pos += RECORD_HEADER_SIZE + length;
+    }
+    return pos;
+}
+
+static bool splitWordRecord(std::string_view payload, std::string_view &word, std::string_view &meaning)
+{
+    uint32_t wordLength;
+    if (payload.size() < sizeof(wordLength))
+        return false;
+    std::memcpy(&wordLength, payload.data(), sizeof(wordLength));
+    if (wordLength > payload.size() - sizeof(wordLength))
+        return false;
+    word = payload.substr(sizeof(wordLength), wordLength);
+    meaning = payload.substr(sizeof(wordLength) + wordLength);
+    return true;
+}
+
+static std::vector<std::string> splitRecentWords(std::string_view list)
+{
+    std::vector<std::string> words;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string_view::npos)
+            comma = list.size();
+        if (comma > pos)
+            words.emplace_back(list.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    return words;
+}
+
+static bool readFile(const std::string &path, std::string &contents)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Returns the size of a file, or 0 if it does not exist.
+static uint64_t fileSize(const std::string &path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? uint64_t(info.st_size) : 0;
+}
+
+// Writes all of `data`, continuing after short writes.
+static bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0)
+            return false;
+        data += written;
+        size -= size_t(written);
+    }
+    return true;
+}
+
+// Cuts a file back to `size` if it has grown past it, then appends `text` and syncs it.
+static bool appendToFile(const std::string &path, uint64_t size, const std::string &text)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+    bool written = (fileSize(path) <= size || ::ftruncate(fd, off_t(size)) == 0) &&
+                   ::lseek(fd, 0, SEEK_END) >= 0 && writeAll(fd, text.data(), text.size()) && ::fsync(fd) == 0;
+    ::close(fd);
+    return written;
+}
+
+// Writes the file next to its target, syncs it, and renames it over the target, so a reader sees
+// either the old contents or the new ones.
+static bool replaceFile(const std::string &path, const std::string &contents)
+{
+    std::string tempPath = path + ".tmp";
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    bool written = writeAll(fd, contents.data(), contents.size()) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string &logFilename, const std::string &wordFilename, const std::string &meaningFilename,
+                             const std::string &recentFilename, bool syncEachCommit)
+    : logFilename(logFilename), wordFilename(wordFilename), meaningFilename(meaningFilename),
+      recentFilename(recentFilename), syncEachCommit(syncEachCommit)
+{
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    close();
+}
+
+bool WriteAheadLog::recover()
+{
+    return compact();
+}
+
+// Records left over from the last run (if recover() could not compact them) are applied to the
+// trie, then compacted into the text files straight away, so the log always starts out empty and
+// its header matches the files.
+bool WriteAheadLog::open(Trie *trie)
+{
+    meaningsMapped = trie->meaningText.isOpen();
+    std::string recentList;
+    if (readFile(recentFilename, recentList))
+    {
+        while (!recentList.empty() && (recentList.back() == '\n' || recentList.back() == '\r'))
+            recentList.pop_back();
+        recent = splitRecentWords(recentList);
+    }
+
+    std::string log;
+    std::vector<LogRecord> records;
+    LogHeader header;
+    size_t intactEnd = 0;
+    if (readFile(logFilename, log) && log.size() >= sizeof(header))
+    {
+        std::memcpy(&header, log.data(), sizeof(header));
+        if (std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) == 0 && header.version == LOG_VERSION)
+            intactEnd = parseRecords(log, records);
+    }
+    for (const LogRecord &record : records)
+    {
+        std::string_view word, meaning;
+        if (record.type == RECORD_WORD && splitWordRecord(record.payload, word, meaning))
+            insert(trie, word, meaning);
+        else if (record.type == RECORD_RECENT)
+            recent = splitRecentWords(record.payload);
+    }
+
+    if (records.empty())
+    {
+        if (!startLog())
+            return false;
+    }
+    else if (!compact())
+    {
+        // Keep appending to the old log, after its last intact record.
+        if (::truncate(logFilename.c_str(), off_t(intactEnd)) != 0)
+            return false;
+        fd = ::open(logFilename.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0)
+            return false;
+        logBytes = intactEnd;
+    }
+    writer = std::thread(&WriteAheadLog::run, this);
+    return true;
+}
+
+void WriteAheadLog::addWord(std::string_view word, std::string_view meaning)
+{
+    uint32_t wordLength = uint32_t(word.size());
+    std::string payload(reinterpret_cast<const char *>(&wordLength), sizeof(wordLength));
+    payload.append(word);
+    payload.append(meaning);
+    std::lock_guard<std::mutex> lock(mutex);
+    appendRecord(pending, RECORD_WORD, payload);
+    wake.notify_one();
+}
+
+void WriteAheadLog::setRecentWords(const std::vector<std::string> &words)
+{
+    std::string payload;
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if (i > 0)
+            payload.push_back(',');
+        payload += words[i];
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    appendRecord(pending, RECORD_RECENT, payload);
+    wake.notify_one();
+}
+
+void WriteAheadLog::close()
+{
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        compact();
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// Once a record arrives, waits out the commit window so the records that follow it share its
+// write and sync. On stop, whatever is still pending is written before the thread ends.
+void WriteAheadLog::run()
+{
+    std::string batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty())
+            break;
+        wake.wait_for(lock, COMMIT_WINDOW, [this] { return stopping; });
+        batch.swap(pending);
+        lock.unlock();
+
+        writeBatch(batch);
+        batch.clear();
+        if (logBytes >= COMPACT_BYTES)
+            compact();
+
+        lock.lock();
+    }
+}
+
+void WriteAheadLog::writeBatch(const std::string &batch)
+{
+    if (!writeAll(fd, batch.data(), batch.size()))
+    {
+        std::perror(logFilename.c_str());
+        return;
+    }
+    if (syncEachCommit && ::fsync(fd) != 0)
+        std::perror(logFilename.c_str());
+    logBytes += batch.size();
+}
+
+// Applies the records on disk to the text files, then replaces the log with an empty one. If
+// anything fails the log is kept, and the next compaction or startup tries again; since the text
+// files are first cut back to the sizes in the log header, applying the records twice is harmless.
+bool WriteAheadLog::compact()
+{
+    std::string log;
+    std::vector<LogRecord> records;
+    LogHeader header;
+    if (!readFile(logFilename, log) || log.size() < sizeof(header))
+        return startLog();
+    std::memcpy(&header, log.data(), sizeof(header));
+    parseRecords(log, records);
+    if (meaningsMapped && fileSize(meaningFilename) > header.meaningsSize)
+        return false; // Cutting the mapped file back is left to recover() at the next start
+
+    std::string words, meanings;
+    const LogRecord *lastRecent = nullptr;
+    for (const LogRecord &record : records)
+    {
+        std::string_view word, meaning;
+        if (record.type == RECORD_WORD && splitWordRecord(record.payload, word, meaning))
+        {
+            words.append(word).push_back('\n');
+            meanings.append(meaning).push_back('\n');
+        }
+        else if (record.type == RECORD_RECENT)
+            lastRecent = &record;
+    }
+
+    if (!words.empty() && (!appendToFile(wordFilename, header.wordsSize, words) || !appendToFile(meaningFilename, header.meaningsSize, meanings)))
+    {
+        std::perror(wordFilename.c_str());
+        return false;
+    }
+    if (lastRecent != nullptr && !replaceFile(recentFilename, std::string(lastRecent->payload)))
+    {
+        std::perror(recentFilename.c_str());
+        return false;
+    }
+    return startLog();
+}
+
+// Replaces the log with just a header holding the current sizes of the text files.
+bool WriteAheadLog::startLog()
+{
+    LogHeader header = {};
+    std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    header.version = LOG_VERSION;
+    header.wordsSize = fileSize(wordFilename);
+    header.meaningsSize = fileSize(meaningFilename);
+    if (!replaceFile(logFilename, std::string(reinterpret_cast<const char *>(&header), sizeof(header))))
+    {
+        std::perror(logFilename.c_str());
+        return false;
+    }
+
+    int newFd = ::open(logFilename.c_str(), O_WRONLY | O_APPEND);
+    if (newFd < 0)
+        return false;
+    if (fd >= 0)
+        ::close(fd);
+    fd = newFd;
+    logBytes = sizeof(header);
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Trie.h"
+
+// Append-only log of the changes the app makes to its files: added words (with their meanings)
+// and the list of recent searches. The UI thread only encodes a record into memory; a background
+// thread writes whatever has gathered in one write() and, if asked to, one fdatasync() (group
+// commit). On startup the log is replayed over the text files, and from time to time it is
+// compacted into them: the words are appended to the word and meaning files, recent.txt is
+// rewritten, and the log starts over empty.
+//
+// Every record carries a CRC-32, so a record torn by a crash is recognized and dropped along with
+// anything after it. A word and its meaning are one record, so they can no longer end up on
+// different lines of the two files. The log header records the sizes of the word and meaning
+// files it applies to; if they are larger, a compaction was cut short, and the files are cut back
+// to those sizes before the records are applied again. A meaning file mapped by a lazily loaded
+// trie is never cut back, as that would pull pages from under the mapping: the log is then kept
+// until recover() runs at the next start, before anything maps the file.
+class WriteAheadLog
+{
+public:
+    static constexpr size_t COMPACT_BYTES = 1 << 20;                   // Compact once the log is this large
+    static constexpr std::chrono::milliseconds COMMIT_WINDOW{20};      // How long a batch gathers records
+    static constexpr size_t MAX_RECENT_WORDS = 5;
+
+    WriteAheadLog(const std::string &logFilename, const std::string &wordFilename, const std::string &meaningFilename,
+                  const std::string &recentFilename, bool syncEachCommit = true);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // Compacts the records left by the last run into the text files. Called before the text files
+    // are loaded (or mapped), which then hold those words. Returns false if they could not be
+    // written, in which case open() replays the records instead.
+    bool recover();
+
+    // Reads recent.txt, replays the log (inserting its words into the trie, which must already hold
+    // the text files), cuts off a torn tail, and starts the background writer. Returns false if the
+    // log cannot be created or opened.
+    bool open(Trie *trie);
+
+    // Queue a record for the background writer; neither touches a file. Any thread.
+    void addWord(std::string_view word, std::string_view meaning);
+    void setRecentWords(const std::vector<std::string> &words);
+
+    // The recent searches as of open(), including those replayed from the log.
+    const std::vector<std::string> &recentWords() const { return recent; }
+
+    // Writes what is still queued, stops the writer and compacts the log. Called by the destructor.
+    void close();
+
+private:
+    void run();
+    void writeBatch(const std::string &batch);
+    bool compact();
+    bool startLog();
+
+    std::string logFilename, wordFilename, meaningFilename, recentFilename;
+    bool syncEachCommit;
+    bool meaningsMapped = false; // The trie passed to open() reads its meanings from the mapped meaning file
+    std::vector<std::string> recent;
+
+    int fd = -1;
+    size_t logBytes = 0; // Writer thread only, once open() returns
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::string pending; // Encoded records not yet written
+    bool stopping = false;
+    std::thread writer;
+};
+
+#endif // WRITE_AHEAD_LOG_H
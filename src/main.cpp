@@ -3,39 +3,156 @@
 #include <string>
 #include <algorithm>
 #include "UI.h"
-#include "Trie.h"  // Trie functions: getNode(), insert(), getMeaning(), getSuggestions(), etc.
+#include "Trie.h"  // Trie functions: createTrie(), insert(), getMeaning(), getCompletions(), etc.
+#include "DictionaryLoader.h"
+#include "DictionaryImage.h"
+#include "FrozenTrie.h"
+#include "DefinitionIndex.h"
+#include "SuggestionRanker.h"
+#include "QueryWorker.h"
+#include "WriteAheadLog.h"
+#include "Metrics.h"
 
 /**
  * @brief Main function to initialize and run the Dictionary Application.
  * 
- * - Loads the dictionary from files into a Trie.
+ * - Maps the dictionary image, or loads the dictionary from the text files into a Trie. With
+ *   --lazy-meanings, the meanings are left in the mapped meaning file and only read when viewed.
+ * - Merges the words and recent searches saved in the write-ahead log into the text files before
+ *   loading them, or replays them if the files cannot be written.
+ * - Indexes the definitions for reverse lookup (with --lazy-meanings, on the first search by meaning).
+ * - Scores words for ranked suggestions from frequency.txt (if present) and recent searches.
+ * - With --freeze, compiles the Trie into a smaller, read-only FrozenTrie and answers from it.
+ * - Starts the worker thread that answers dictionary queries for the UI.
  * - Initializes the graphical user interface (GUI).
  * - Manages screen transitions (Home, Search, Add Word).
- * - Runs the main application loop until the window is closed.
+ * - Runs the main application loop until the window is closed, drawing frames only on input or
+ *   while the screen is changing.
+ * - Writes the performance counters to metrics.json on exit, when built with them.
  * 
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments; "--lazy-meanings" turns on lazy meaning loading,
+ *             "--compress-meanings" keeps the meanings compressed in memory and "--freeze"
+ *             answers queries from a FrozenTrie (and turns the other two off).
  * @return int Returns 0 on successful execution, 1 if files fail to open.
  */
-int main()
+int main(int argc, char *argv[])
 {
-    // Create the root node for the Trie data structure.
-    TrieNode *dictionary = getNode();
+    // With --lazy-meanings, the meanings stay in the mapped meaning.txt: resident memory then grows
+    // with the words viewed instead of with the dictionary, at the cost of a page read the first
+    // time each meaning is shown. With --compress-meanings, the meanings are compressed once loaded
+    // and decoded each time one is read, which roughly halves the memory they take. With --freeze,
+    // the loaded Trie is compiled into a FrozenTrie, which takes a fraction of the node memory but
+    // looks meanings up several times slower and does not rank suggestions. Freezing copies every
+    // meaning into the frozen trie, so it is not combined with the other two.
+    bool lazyMeanings = false;
+    bool compressedMeanings = false;
+    bool freeze = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--lazy-meanings")
+            lazyMeanings = true;
+        else if (std::string(argv[i]) == "--compress-meanings")
+            compressedMeanings = true;
+        else if (std::string(argv[i]) == "--freeze")
+            freeze = true;
+    }
+    if (freeze)
+        lazyMeanings = compressedMeanings = false;
 
-    // Open the dictionary files (words in "oxford.txt", meanings in "meaning.txt").
-    std::ifstream inOxford("oxford.txt"), inMeaning("meaning.txt");
-    if (!inOxford || !inMeaning)
+    // Merge the changes logged by the last run into the text files before they are loaded, so the
+    // log never changes a meaning file that --lazy-meanings has mapped.
+    WriteAheadLog changes("changes.log", "oxford.txt", "meaning.txt", "recent.txt");
+    {
+        METRICS_SCOPE(METRIC_LOAD_REPLAY_LOG);
+        changes.recover();
+    }
+
+    // Map the precompiled dictionary image. It is used in place, so startup does not depend on the
+    // dictionary size. The text files are only read when the image is missing or older than them.
+    // Each startup phase is timed for the performance overlay.
+    Trie *dictionary = nullptr;
+    if (!lazyMeanings && !compressedMeanings)
+    {
+        METRICS_SCOPE(METRIC_LOAD_IMAGE);
+        dictionary = openDictionaryImage("dictionary.img", "oxford.txt", "meaning.txt");
+    }
+    if (dictionary == nullptr)
     {
-        std::cerr << "Error: Could not open dictionary files." << std::endl;
-        return 1;
+        // Load words (from "oxford.txt") and meanings (from "meaning.txt") into an empty Trie.
+        dictionary = createTrie();
+        bool loaded;
+        {
+            METRICS_SCOPE(METRIC_LOAD_TEXT);
+            if (lazyMeanings)
+                loaded = loadTextDictionaryLazy(dictionary, "oxford.txt", "meaning.txt");
+            else
+                loaded = loadTextDictionaryParallel(dictionary, "oxford.txt", "meaning.txt");
+        }
+        if (!loaded)
+        {
+            std::cerr << "Error: Could not open dictionary files." << std::endl;
+            deleteTrie(dictionary);
+            return 1;
+        }
+
+        // Save a fresh image so the next start can map it instead. Not when loading lazily, as
+        // writing the image would read every meaning, nor when compressing, which the image
+        // cannot hold.
+        if (!lazyMeanings && !compressedMeanings)
+        {
+            METRICS_SCOPE(METRIC_LOAD_WRITE_IMAGE);
+            if (!writeDictionaryImage(dictionary, "dictionary.img", "oxford.txt", "meaning.txt"))
+                std::cerr << "Warning: Could not write dictionary.img." << std::endl;
+        }
     }
 
-    // Read words and their meanings from the files and insert them into the Trie.
-    std::string word, meaning;
-    while (std::getline(inOxford, word) && std::getline(inMeaning, meaning))
+    // Compress before the logged changes are applied, so the words they add are stored encoded.
+    if (compressedMeanings)
     {
-        insert(dictionary, word, meaning);
+        METRICS_SCOPE(METRIC_LOAD_COMPRESS);
+        compressMeanings(dictionary);
     }
-    inOxford.close();
-    inMeaning.close();
+
+    // Apply any logged changes recover() could not merge, and start saving new ones in the background.
+    if (!changes.open(dictionary))
+        std::cerr << "Warning: Could not open changes.log; added words will not be saved." << std::endl;
+
+    // Index the definitions so words can also be found by their meaning. This reads every meaning,
+    // so a lazily loaded dictionary leaves it to the query worker, for the first search that needs it.
+    DefinitionIndex definitions;
+    if (!lazyMeanings)
+    {
+        METRICS_SCOPE(METRIC_LOAD_INDEX);
+        indexDefinitions(definitions, dictionary);
+    }
+
+    // Score words so suggestions can be ranked: by their counts in the optional frequency file,
+    // and by recent lookups.
+    SuggestionRanker ranker;
+    {
+        METRICS_SCOPE(METRIC_LOAD_RANKER);
+        loadWordFrequencies(ranker, dictionary, "frequency.txt");
+        for (const std::string &recentWord : changes.recentWords())
+        {
+            if (search(dictionary, recentWord))
+                ranker.addScore(recentWord, SuggestionRanker::LOOKUP_SCORE);
+        }
+    }
+
+    // Freeze once the log, the index and the ranker have read the Trie; new words then go to the
+    // frozen trie's overlay.
+    FrozenTrie *frozen = nullptr;
+    if (freeze)
+    {
+        METRICS_SCOPE(METRIC_LOAD_FREEZE);
+        frozen = freezeTrie(dictionary);
+        deleteTrie(dictionary);
+    }
+
+    // From here on only the query worker touches the dictionary, the index and the ranker.
+    QueryWorker queries = frozen != nullptr ? QueryWorker(frozen, &definitions, &ranker)
+                                            : QueryWorker(dictionary, &definitions, &ranker, !lazyMeanings);
 
     // Initialize UI with screen dimensions.
     const int screenWidth = 1600;
@@ -46,7 +163,8 @@ int main()
     // Screen state management variable.
     Screen currentScreen = HOME;
 
-    // Main application loop: Runs until the user closes the window.
+    // Main application loop: Runs until the user closes the window. Frames are only drawn on input
+    // and while the screen is changing; in between, the window sleeps until the next input event.
     while (!WindowShouldClose())
     {
         switch (currentScreen)
@@ -58,19 +176,25 @@ int main()
 
             case SEARCH:
                 // Render the search screen; return to home if back button is pressed.
-                if (DrawSearchScreen(dictionary))
+                if (DrawSearchScreen(&queries, &changes))
                     currentScreen = HOME;
                 break;
 
             case ADDWORD:
                 // Render the add word screen; return to home if back button is pressed.
-                if (DrawAddWordScreen(dictionary, "oxford.txt", "meaning.txt"))
+                if (DrawAddWordScreen(&queries, &changes))
                     currentScreen = HOME;
                 break;
         }
     }
 
-    // Clean up resources and close the application.
+    // Stop the worker before the dictionary is deleted, write out the log, then clean up and close
+    // the application.
+    queries.stop();
+    changes.close();
+    if (METRICS_ENABLED && !dumpMetrics("metrics.json"))
+        std::cerr << "Warning: Could not write metrics.json." << std::endl;
     CloseUI(dictionary);
+    deleteTrie(frozen);
     return 0;
 }
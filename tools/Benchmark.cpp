@@ -0,0 +1,557 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "Trie.h"
+#include "DictionaryLoader.h"
+#include "DictionaryParser.h"
+#include "VersionedTrie.h"
+#include "FrozenTrie.h"
+#include "RadixTrie.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Latency of one kind of operation. Every call is timed on its own, so the numbers include the
+// cost of reading the clock, which is reported separately.
+struct OperationStats {
+    std::string name;
+    size_t count = 0;
+    double meanNs = 0, p50Ns = 0, p90Ns = 0, p99Ns = 0, maxNs = 0;
+};
+
+// Throughput of VersionedTrie readers while a writer keeps changing the trie.
+struct ReaderScaling {
+    size_t threads = 0;
+    double readsPerSecond = 0;  // All readers together
+    double writesPerSecond = 0;
+};
+
+struct DatasetResult {
+    std::string name;
+    size_t words = 0;
+    double loadMs = 0, parallelLoadMs = 0, deleteMs = 0, compressMs = 0, radixLoadMs = 0, freezeMs = 0;
+    TrieMemoryUsage usage = {};
+    TrieMemoryUsage radixUsage = {};  // The same words in a RadixTrie
+    TrieMemoryUsage frozenUsage = {}; // The same words in a FrozenTrie
+    size_t rawMeaningBytes = 0, compressedMeaningBytes = 0, codecTableBytes = 0; // Tables kept for decoding
+    size_t rssBytes = 0;     // Resident memory the loaded trie added
+    size_t peakRssBytes = 0; // Peak resident memory of the process so far
+    std::vector<OperationStats> operations;
+    std::vector<ReaderScaling> readerScaling;
+};
+
+// Results are summed into this so the compiler cannot drop the calls being timed.
+static volatile size_t sink;
+
+static double elapsedNs(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static size_t residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+static size_t peakResidentBytes()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return size_t(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+}
+
+// Times op(i) for i in [0, count) one call at a time and summarizes the latencies.
+template <typename Op>
+static OperationStats timeEach(const std::string &name, size_t count, Op op)
+{
+    std::vector<double> samples(count);
+    double total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Clock::time_point start = Clock::now();
+        op(i);
+        samples[i] = elapsedNs(start, Clock::now());
+        total += samples[i];
+    }
+
+    OperationStats stats;
+    stats.name = name;
+    stats.count = count;
+    if (count == 0)
+        return stats;
+    std::sort(samples.begin(), samples.end());
+    stats.meanNs = total / double(count);
+    stats.p50Ns = samples[count / 2];
+    stats.p90Ns = samples[count * 90 / 100];
+    stats.p99Ns = samples[count * 99 / 100];
+    stats.maxNs = samples.back();
+    return stats;
+}
+
+// Turns the latencies of calls that each handle `items` items into latencies per item.
+static OperationStats perItem(OperationStats stats, size_t items)
+{
+    double scale = 1.0 / double(items);
+    stats.count *= items;
+    stats.meanNs *= scale;
+    stats.p50Ns *= scale;
+    stats.p90Ns *= scale;
+    stats.p99Ns *= scale;
+    stats.maxNs *= scale;
+    return stats;
+}
+
+// Runs `threads` reader threads doing pinned getMeaning() lookups for `ms` milliseconds while one
+// writer inserts and removes words that are not in the dictionary, then counts what got done.
+static ReaderScaling measureReaders(VersionedTrie &versioned, const std::vector<std::string> &queries,
+                                    const std::vector<std::string> &added, size_t threads, int ms)
+{
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> reads{0}, writes{0};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < threads; t++)
+    {
+        readers.emplace_back([&, t] {
+            VersionedTrie::Reader reader(versioned);
+            size_t done = 0, total = 0;
+            for (size_t i = t * 7919; !stop.load(std::memory_order_relaxed); i++, done++)
+            {
+                VersionedTrie::Pin pin(reader);
+                total += getMeaning(reader.trie(), queries[i % queries.size()]).size();
+            }
+            reads += done;
+            sink = sink + total;
+        });
+    }
+    std::thread writer([&] {
+        size_t done = 0;
+        for (size_t i = 0; !stop.load(std::memory_order_relaxed); i++, done += 2)
+        {
+            const std::string &word = added[i % added.size()];
+            versioned.insert(word, "noun|Added while reading.");
+            versioned.remove(word);
+        }
+        writes = done;
+    });
+
+    Clock::time_point start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop = true;
+    for (std::thread &reader : readers)
+        reader.join();
+    writer.join();
+    double seconds = elapsedNs(start, Clock::now()) / 1e9;
+
+    ReaderScaling scaling;
+    scaling.threads = threads;
+    scaling.readsPerSecond = double(reads) / seconds;
+    scaling.writesPerSecond = double(writes) / seconds;
+    return scaling;
+}
+
+// Cost of the two clock reads around every timed call.
+static double clockOverheadNs()
+{
+    OperationStats empty = timeEach("clock", 100000, [](size_t) {});
+    return empty.p50Ns;
+}
+
+// Words of 3 to 12 letters drawn with roughly English letter frequencies, with a short meaning
+// tagged with a part of speech like the shipped dictionary's.
+static void makeSyntheticDictionary(size_t count, uint64_t seed, std::vector<std::string> &words, std::vector<std::string> &meanings)
+{
+    static const char LETTERS[] = "eeeeeeeeeeeetttttttttaaaaaaaaoooooooiiiiiiinnnnnnnsssssshhhhhhrrrrrrddddllllccmmuuwwffggyyppbvkjxqz";
+    static const char *TAGS[] = {"(n.)", "(v.)", "(a.)", "(adv.)"};
+    std::mt19937_64 random(seed);
+    words.resize(count);
+    meanings.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t length = 3 + random() % 10;
+        words[i].clear();
+        for (size_t j = 0; j < length; j++)
+            words[i].push_back(LETTERS[random() % (sizeof(LETTERS) - 1)]);
+        meanings[i] = std::string(TAGS[random() % 4]) + " Synthetic meaning number " + std::to_string(i) + ".";
+    }
+}
+
+static bool writeLines(const std::string &path, const std::vector<std::string> &lines)
+{
+    std::ofstream file(path, std::ios::trunc);
+    for (const std::string &line : lines)
+        file << line << '\n';
+    return bool(file);
+}
+
+static bool readLines(const std::string &path, std::vector<std::string> &lines)
+{
+    LineReader reader(path);
+    if (!reader.isOpen())
+        return false;
+    std::string_view line;
+    while (reader.next(line))
+        lines.emplace_back(line);
+    return true;
+}
+
+// Runs every measurement on one word list. The files are loaded the way the app loads them, the
+// in-memory lists drive the per-operation timings.
+static DatasetResult runDataset(const std::string &name, const std::string &wordFile, const std::string &meaningFile,
+                                const std::vector<std::string> &words, const std::vector<std::string> &meanings, uint64_t seed)
+{
+    DatasetResult result;
+    result.name = name;
+    std::mt19937_64 random(seed);
+
+    // ----- Loading -----
+    size_t rssBefore = residentBytes();
+    Clock::time_point start = Clock::now();
+    Trie *trie = createTrie();
+    loadTextDictionary(trie, wordFile, meaningFile);
+    result.loadMs = elapsedNs(start, Clock::now()) / 1e6;
+    size_t rssAfter = residentBytes();
+    result.rssBytes = rssAfter > rssBefore ? rssAfter - rssBefore : 0;
+    result.words = countWords(trie, "");
+    result.usage = getMemoryUsage(trie);
+
+    start = Clock::now();
+    Trie *parallel = createTrie();
+    loadTextDictionaryParallel(parallel, wordFile, meaningFile);
+    result.parallelLoadMs = elapsedNs(start, Clock::now()) / 1e6;
+    deleteTrie(parallel);
+
+    // ----- Insert, into a fresh trie -----
+    Trie *built = createTrie();
+    result.operations.push_back(timeEach("insert", words.size(), [&](size_t i) { insert(built, words[i], meanings[i]); }));
+    deleteTrie(built);
+
+    // ----- Lookups: half of the searches miss -----
+    size_t lookups = std::min<size_t>(words.size(), 1000000);
+    std::vector<std::string> queries(lookups);
+    for (size_t i = 0; i < lookups; i++)
+    {
+        queries[i] = words[random() % words.size()];
+        if (i % 2 == 1)
+            queries[i] += "qz"; // Almost never a word
+    }
+    result.operations.push_back(timeEach("search", lookups, [&](size_t i) { sink = sink + search(trie, queries[i]); }));
+    result.operations.push_back(timeEach("getMeaning", lookups / 2, [&](size_t i) { sink = sink + getMeaning(trie, queries[i * 2]).size(); }));
+
+    // The same words through getMeanings(), timed per batch and reported per word
+    const size_t batchSize = 1024;
+    std::vector<std::vector<std::string_view>> batches(lookups / 2 / batchSize);
+    for (size_t b = 0; b < batches.size(); b++)
+    {
+        for (size_t i = 0; i < batchSize; i++)
+            batches[b].push_back(queries[(b * batchSize + i) * 2]);
+    }
+    OperationStats batched = timeEach("getMeanings_1024", batches.size(), [&](size_t b) { sink = sink + getMeanings(trie, batches[b]).size(); });
+    result.operations.push_back(perItem(batched, batchSize));
+
+    // ----- Suggestions by prefix length; short prefixes match much of the dictionary -----
+    const size_t prefixLengths[] = {1, 2, 3, 5};
+    for (size_t length : prefixLengths)
+    {
+        size_t count = length == 1 ? 100 : length == 2 ? 1000 : 10000;
+        std::vector<std::string> prefixes(count);
+        for (std::string &prefix : prefixes)
+            prefix = words[random() % words.size()].substr(0, length);
+        std::string suffix = "_" + std::to_string(length);
+        result.operations.push_back(timeEach("getSuggestions" + suffix, count, [&](size_t i) { sink = sink + getSuggestions(trie, prefixes[i]).size(); }));
+        result.operations.push_back(timeEach("getCompletions10" + suffix, count, [&](size_t i) { sink = sink + getCompletions(trie, prefixes[i], 10).size(); }));
+    }
+
+    // ----- Scrolling: 10 completions of a one-letter prefix per page, each page resuming where the last ended -----
+    PrefixCursor cursor;
+    cursorSeek(cursor, trie, words[random() % words.size()].substr(0, 1));
+    CompletionIterator scroll;
+    size_t pages = std::min<size_t>(10000, countWords(cursor) / 10);
+    result.operations.push_back(timeEach("completionPage10_1", pages, [&](size_t i) {
+        completionSeek(scroll, cursor, i * 10);
+        for (int row = 0; row < 10 && completionValid(scroll); row++, completionNext(scroll))
+            sink = sink + scroll.word.size();
+    }));
+
+    // ----- Remove a tenth of the words -----
+    std::vector<std::string> removals(words.size() / 10);
+    for (std::string &word : removals)
+        word = words[random() % words.size()];
+    result.operations.push_back(timeEach("remove", removals.size(), [&](size_t i) { sink = sink + remove(trie, removals[i]); }));
+
+    // ----- Readers on 1, 2, 4 and every core, with a writer changing the trie meanwhile -----
+    {
+        std::vector<std::string> added(1024);
+        for (size_t i = 0; i < added.size(); i++)
+            added[i] = words[random() % words.size()] + "qzx"; // Almost never a word
+        size_t cores = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), VersionedTrie::MAX_READERS);
+        std::vector<size_t> threadCounts = {1, 2, 4, cores};
+        std::sort(threadCounts.begin(), threadCounts.end());
+        threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+        VersionedTrie versioned(trie);
+        for (size_t threads : threadCounts)
+            result.readerScaling.push_back(measureReaders(versioned, queries, added, threads, 200));
+    }
+
+    result.peakRssBytes = peakResidentBytes();
+    start = Clock::now();
+    deleteTrie(trie);
+    result.deleteMs = elapsedNs(start, Clock::now()) / 1e6;
+
+    // ----- Compressed meanings, in a fresh trie: the same lookups, and decoding on its own -----
+    Trie *compressed = createTrie();
+    loadTextDictionaryParallel(compressed, wordFile, meaningFile);
+    result.rawMeaningBytes = compressed->meanings.bytesUsed();
+    start = Clock::now();
+    compressMeanings(compressed);
+    result.compressMs = elapsedNs(start, Clock::now()) / 1e6;
+    result.compressedMeaningBytes = compressed->meanings.bytesUsed();
+    result.codecTableBytes = compressed->codec.tableBytes();
+
+    std::string buffer;
+    result.operations.push_back(timeEach("getMeaningCompressed", lookups / 2, [&](size_t i) { sink = sink + getMeaning(compressed, queries[i * 2], buffer).size(); }));
+    std::vector<std::string> codes(std::min<size_t>(meanings.size(), 100000));
+    for (std::string &code : codes)
+        compressed->codec.encode(meanings[random() % meanings.size()], code);
+    result.operations.push_back(timeEach("decodeMeaning", codes.size(), [&](size_t i) { sink = sink + compressed->codec.decode(codes[i], buffer).size(); }));
+    deleteTrie(compressed);
+
+    // ----- The same words in a path-compressed RadixTrie -----
+    start = Clock::now();
+    RadixTrie *radix = createRadixTrie();
+    loadTextDictionary(radix, wordFile, meaningFile);
+    result.radixLoadMs = elapsedNs(start, Clock::now()) / 1e6;
+    result.radixUsage = getMemoryUsage(radix);
+    result.operations.push_back(timeEach("radix_search", lookups, [&](size_t i) { sink = sink + search(radix, queries[i]); }));
+    result.operations.push_back(timeEach("radix_getMeaning", lookups / 2, [&](size_t i) { sink = sink + getMeaning(radix, queries[i * 2]).size(); }));
+    for (size_t length : {size_t(1), size_t(3)})
+    {
+        std::vector<std::string> prefixes(length == 1 ? 100 : 10000);
+        for (std::string &prefix : prefixes)
+            prefix = words[random() % words.size()].substr(0, length);
+        result.operations.push_back(timeEach("radix_completions10_" + std::to_string(length), prefixes.size(),
+                                             [&](size_t i) { sink = sink + getCompletions(radix, prefixes[i], 10).size(); }));
+    }
+    deleteTrie(radix);
+
+    // ----- The same words frozen into a FrozenTrie, with an empty overlay -----
+    Trie *unfrozen = createTrie();
+    loadTextDictionaryParallel(unfrozen, wordFile, meaningFile);
+    start = Clock::now();
+    FrozenTrie *frozen = freezeTrie(unfrozen);
+    result.freezeMs = elapsedNs(start, Clock::now()) / 1e6;
+    deleteTrie(unfrozen);
+    result.frozenUsage = getMemoryUsage(frozen);
+    result.operations.push_back(timeEach("frozen_search", lookups, [&](size_t i) { sink = sink + search(frozen, queries[i]); }));
+    result.operations.push_back(timeEach("frozen_getMeaning", lookups / 2, [&](size_t i) { sink = sink + getMeaning(frozen, queries[i * 2]).size(); }));
+    for (size_t length : {size_t(1), size_t(3)})
+    {
+        std::vector<std::string> prefixes(length == 1 ? 100 : 10000);
+        for (std::string &prefix : prefixes)
+            prefix = words[random() % words.size()].substr(0, length);
+        result.operations.push_back(timeEach("frozen_completions10_" + std::to_string(length), prefixes.size(),
+                                             [&](size_t i) { sink = sink + getCompletions(frozen, prefixes[i], 10).size(); }));
+    }
+    deleteTrie(frozen);
+    return result;
+}
+
+static void printResult(const DatasetResult &result)
+{
+    double bytesPerWord = double(result.usage.nodeBytesUsed + result.usage.meaningBytesUsed) / double(std::max<size_t>(result.words, 1));
+    std::printf("\n%s: %zu words, load %.1f ms (parallel %.1f ms), delete %.2f ms\n", result.name.c_str(), result.words,
+                result.loadMs, result.parallelLoadMs, result.deleteMs);
+    std::printf("  %zu nodes, %.1f bytes/word in nodes and meanings, %.1f bytes/word resident, peak RSS %.1f MiB\n",
+                result.usage.nodeCount, bytesPerWord, double(result.rssBytes) / double(std::max<size_t>(result.words, 1)),
+                double(result.peakRssBytes) / (1 << 20));
+    long long netSaved = (long long)result.rawMeaningBytes - (long long)(result.compressedMeaningBytes + result.codecTableBytes);
+    std::printf("  meanings compressed in %.1f ms: %zu -> %zu bytes (%.2fx) + %zu bytes of tables, %lld bytes saved in all\n",
+                result.compressMs, result.rawMeaningBytes, result.compressedMeaningBytes,
+                double(result.rawMeaningBytes) / double(std::max<size_t>(result.compressedMeaningBytes, 1)), result.codecTableBytes, netSaved);
+    std::printf("  radix trie: %zu nodes, %.1f bytes/word in nodes and meanings, load %.1f ms\n", result.radixUsage.nodeCount,
+                double(result.radixUsage.nodeBytesUsed + result.radixUsage.meaningBytesUsed) / double(std::max<size_t>(result.words, 1)),
+                result.radixLoadMs);
+    std::printf("  frozen trie: %zu nodes, %.1f bytes/node (%.1f unfrozen), %.1f bytes/word in nodes and meanings, freeze %.1f ms\n",
+                result.frozenUsage.nodeCount,
+                double(result.frozenUsage.nodeBytesUsed) / double(std::max<size_t>(result.frozenUsage.nodeCount, 1)),
+                double(result.usage.nodeBytesUsed) / double(std::max<size_t>(result.usage.nodeCount, 1)),
+                double(result.frozenUsage.nodeBytesUsed + result.frozenUsage.meaningBytesUsed) / double(std::max<size_t>(result.words, 1)),
+                result.freezeMs);
+    std::printf("  %-22s %10s %10s %10s %10s %10s %12s\n", "operation", "count", "mean ns", "p50 ns", "p90 ns", "p99 ns", "max ns");
+    for (const OperationStats &op : result.operations)
+        std::printf("  %-22s %10zu %10.0f %10.0f %10.0f %10.0f %12.0f\n", op.name.c_str(), op.count, op.meanNs, op.p50Ns, op.p90Ns, op.p99Ns, op.maxNs);
+    for (const ReaderScaling &scaling : result.readerScaling)
+        std::printf("  %2zu readers + 1 writer: %8.2f M reads/s (%.2f M per reader), %8.3f M writes/s\n", scaling.threads,
+                    scaling.readsPerSecond / 1e6, scaling.readsPerSecond / 1e6 / double(scaling.threads), scaling.writesPerSecond / 1e6);
+}
+
+// Escapes quotes, backslashes and control characters for a JSON string.
+static std::string jsonString(const std::string &text)
+{
+    std::string quoted = "\"";
+    for (char ch : text)
+    {
+        if (ch == '"' || ch == '\\')
+            quoted.push_back('\\');
+        if (static_cast<unsigned char>(ch) < 0x20)
+            ch = ' ';
+        quoted.push_back(ch);
+    }
+    return quoted + "\"";
+}
+
+static bool writeJson(const std::string &path, const std::vector<DatasetResult> &results, double clockNs)
+{
+    std::ofstream out(path, std::ios::trunc);
+#ifdef NDEBUG
+    const char *buildType = "release";
+#else
+    const char *buildType = "debug";
+#endif
+    out << "{\n  \"build\": \"" << buildType << "\",\n  \"compiler\": " << jsonString(__VERSION__) << ",\n";
+    out << "  \"clock_overhead_ns\": " << clockNs << ",\n  \"datasets\": [\n";
+    for (size_t d = 0; d < results.size(); d++)
+    {
+        const DatasetResult &r = results[d];
+        size_t words = std::max<size_t>(r.words, 1);
+        out << "    {\n      \"name\": " << jsonString(r.name) << ",\n      \"words\": " << r.words << ",\n";
+        out << "      \"load_ms\": " << r.loadMs << ",\n      \"parallel_load_ms\": " << r.parallelLoadMs << ",\n";
+        out << "      \"delete_ms\": " << r.deleteMs << ",\n      \"nodes\": " << r.usage.nodeCount << ",\n";
+        out << "      \"node_bytes\": " << r.usage.nodeBytesUsed << ",\n      \"meaning_bytes\": " << r.usage.meaningBytesUsed << ",\n";
+        out << "      \"bytes_per_word\": " << double(r.usage.nodeBytesUsed + r.usage.meaningBytesUsed) / double(words) << ",\n";
+        out << "      \"rss_bytes_per_word\": " << double(r.rssBytes) / double(words) << ",\n";
+        out << "      \"compress_ms\": " << r.compressMs << ",\n      \"raw_meaning_bytes\": " << r.rawMeaningBytes << ",\n";
+        out << "      \"compressed_meaning_bytes\": " << r.compressedMeaningBytes << ",\n      \"codec_table_bytes\": " << r.codecTableBytes << ",\n";
+        out << "      \"net_saved_meaning_bytes\": "
+            << (long long)r.rawMeaningBytes - (long long)(r.compressedMeaningBytes + r.codecTableBytes) << ",\n";
+        out << "      \"radix_load_ms\": " << r.radixLoadMs << ",\n      \"radix_nodes\": " << r.radixUsage.nodeCount << ",\n";
+        out << "      \"radix_node_bytes\": " << r.radixUsage.nodeBytesUsed << ",\n";
+        out << "      \"freeze_ms\": " << r.freezeMs << ",\n      \"frozen_nodes\": " << r.frozenUsage.nodeCount << ",\n";
+        out << "      \"frozen_node_bytes\": " << r.frozenUsage.nodeBytesUsed << ",\n";
+        out << "      \"peak_rss_bytes\": " << r.peakRssBytes << ",\n      \"operations\": [\n";
+        for (size_t i = 0; i < r.operations.size(); i++)
+        {
+            const OperationStats &op = r.operations[i];
+            out << "        {\"name\": " << jsonString(op.name) << ", \"count\": " << op.count << ", \"mean_ns\": " << op.meanNs
+                << ", \"p50_ns\": " << op.p50Ns << ", \"p90_ns\": " << op.p90Ns << ", \"p99_ns\": " << op.p99Ns
+                << ", \"max_ns\": " << op.maxNs << "}" << (i + 1 < r.operations.size() ? "," : "") << "\n";
+        }
+        out << "      ],\n      \"reader_scaling\": [\n";
+        for (size_t i = 0; i < r.readerScaling.size(); i++)
+        {
+            const ReaderScaling &scaling = r.readerScaling[i];
+            out << "        {\"threads\": " << scaling.threads << ", \"reads_per_s\": " << scaling.readsPerSecond
+                << ", \"writes_per_s\": " << scaling.writesPerSecond << "}" << (i + 1 < r.readerScaling.size() ? "," : "") << "\n";
+        }
+        out << "      ]\n    }" << (d + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return bool(out);
+}
+
+/**
+ * @brief Measures the Trie engine without the UI: loading, insert, search, getMeaning and batched
+ * getMeanings, getSuggestions/getCompletions at several prefix lengths, remove, VersionedTrie reader
+ * throughput on 1, 2, 4 and every core while a writer runs, and deleteTrie, then compressing the
+ * meanings and reading them back, loading, lookups and completions in a RadixTrie, and freezing,
+ * lookups and completions in a FrozenTrie, on the shipped dictionary and on synthetic dictionaries
+ * of the given sizes.
+ *
+ * Usage: Benchmark [--sizes 100000,1000000] [--words <word file> --meanings <meaning file>]
+ *                  [--json <output file>] [--seed <number>]
+ *
+ * Latencies are reported as mean and percentiles in ns, memory as bytes per word and peak RSS.
+ * The results are printed and written as JSON (benchmark.json by default) so runs can be compared.
+ *
+ * @return int Returns 0 on success, 1 on bad arguments or if the JSON file cannot be written.
+ */
+int main(int argc, char **argv)
+{
+    std::string wordFile = "oxford.txt", meaningFile = "meaning.txt", jsonFile = "benchmark.json";
+    std::vector<size_t> sizes = {100000, 1000000};
+    uint64_t seed = 42;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Usage: " << argv[0] << " [--sizes N,N...] [--words <file> --meanings <file>] [--json <file>] [--seed N]" << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sizes")
+        {
+            sizes.clear();
+            for (size_t pos = 0; pos < value.size();)
+            {
+                size_t comma = std::min(value.find(',', pos), value.size());
+                sizes.push_back(std::strtoull(value.substr(pos, comma - pos).c_str(), nullptr, 10));
+                pos = comma + 1;
+            }
+        }
+        else if (arg == "--words")
+            wordFile = value;
+        else if (arg == "--meanings")
+            meaningFile = value;
+        else if (arg == "--json")
+            jsonFile = value;
+        else if (arg == "--seed")
+            seed = std::strtoull(value.c_str(), nullptr, 10);
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    double clockNs = clockOverheadNs();
+    std::printf("Clock overhead: %.0f ns per timed call (included in the latencies below)\n", clockNs);
+
+    std::vector<DatasetResult> results;
+    std::vector<std::string> words, meanings;
+    if (readLines(wordFile, words) && readLines(meaningFile, meanings))
+    {
+        meanings.resize(words.size());
+        results.push_back(runDataset(wordFile, wordFile, meaningFile, words, meanings, seed));
+        printResult(results.back());
+    }
+    else
+        std::cerr << "Warning: Could not open " << wordFile << " or " << meaningFile << "; skipping the shipped dictionary." << std::endl;
+
+    // Synthetic dictionaries are written out so loading is measured from files, as in the app.
+    const std::string syntheticWords = "benchmark_words.txt", syntheticMeanings = "benchmark_meanings.txt";
+    for (size_t size : sizes)
+    {
+        if (size == 0)
+            continue;
+        makeSyntheticDictionary(size, seed + size, words, meanings);
+        if (!writeLines(syntheticWords, words) || !writeLines(syntheticMeanings, meanings))
+        {
+            std::cerr << "Error: Could not write the synthetic dictionary." << std::endl;
+            return 1;
+        }
+        results.push_back(runDataset("synthetic_" + std::to_string(size), syntheticWords, syntheticMeanings, words, meanings, seed));
+        printResult(results.back());
+    }
+    std::remove(syntheticWords.c_str());
+    std::remove(syntheticMeanings.c_str());
+
+    if (!writeJson(jsonFile, results, clockNs))
+    {
+        std::cerr << "Error: Could not write " << jsonFile << "." << std::endl;
+        return 1;
+    }
+    std::printf("\nWrote %s (checksum %zu)\n", jsonFile.c_str(), size_t(sink));
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <iostream>
+#include "Trie.h"
+#include "DictionaryLoader.h"
+#include "DictionaryImage.h"
+
+/**
+ * @brief Compiles the text dictionary into the binary image the app maps at startup.
+ *
+ * Usage: BuildImage <word file> <meaning file> <image file>
+ *
+ * @return int Returns 0 on success, 1 if the text files cannot be read or the image cannot be written
+ *             or fails its checksum when read back.
+ */
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <word file> <meaning file> <image file>" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Trie *dictionary = createTrie();
+    if (!loadTextDictionaryParallel(dictionary, argv[1], argv[2]))
+    {
+        std::cerr << "Error: Could not open dictionary files." << std::endl;
+        deleteTrie(dictionary);
+        return 1;
+    }
+    // The app only checks the header at startup, so the whole image is checked once here.
+    if (!writeDictionaryImage(dictionary, argv[3], argv[1], argv[2]) || !verifyDictionaryImage(argv[3]))
+    {
+        std::cerr << "Error: Could not write " << argv[3] << "." << std::endl;
+        deleteTrie(dictionary);
+        return 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    TrieMemoryUsage usage = getMemoryUsage(dictionary);
+    std::cout << "Wrote " << argv[3] << ": " << countWords(dictionary, "") << " words, " << usage.nodeCount << " nodes, "
+              << usage.nodeBytesUsed << " node bytes, " << usage.meaningBytesUsed << " meaning bytes in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    deleteTrie(dictionary);
+    return 0;
+}
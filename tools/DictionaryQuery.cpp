@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+#include "Trie.h"
+#include "RadixTrie.h"
+#include "DictionaryLoader.h"
+#include "DictionaryImage.h"
+
+enum QueryMode {
+    MODE_EXACT,  // The word's meaning
+    MODE_PREFIX, // Words starting with the query
+    MODE_FUZZY   // Words within an edit distance of the query
+};
+
+enum TrieKind {
+    TRIE_STANDARD, // Trie, mapped from the image when it is up to date
+    TRIE_RADIX     // RadixTrie, loaded from the text files
+};
+
+struct Options {
+    QueryMode mode = MODE_EXACT;
+    TrieKind trie = TRIE_STANDARD;
+    size_t limit = 10;
+    int distance = 1;
+    unsigned threads = 0;
+    std::string input; // Empty for stdin
+    std::string image = "dictionary.img";
+    std::string words = "oxford.txt";
+    std::string meanings = "meaning.txt";
+    bool stats = false;
+};
+
+// Input is cut into batches of whole lines of about this size. Each batch is answered by one
+// thread into its own buffer, and the buffers are written in input order.
+static const size_t BATCH_BYTES = 1 << 20;
+
+// A batch of input lines and the output they produced, numbered in input order.
+struct Batch {
+    size_t sequence;
+    std::string input;
+    std::string output;
+    size_t queries = 0;
+};
+
+// Batches handed between the reader, the query threads and the writer. At most `maxInFlight`
+// batches are read but not yet written, which bounds memory however long the input is.
+struct Pipeline {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Batch> pending;        // Read, waiting for a query thread
+    std::map<size_t, Batch> finished; // Answered, waiting for their turn to be written
+    size_t inFlight = 0;
+    size_t maxInFlight = 0;
+    bool inputDone = false;
+};
+
+// Exact queries are looked up together, so getMeanings() can share prefixes and overlap cache misses.
+static void answerExact(const Trie *trie, const std::vector<std::string_view> &queries, std::string &out)
+{
+    std::vector<std::string_view> meanings = getMeanings(trie, queries);
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        out += queries[i];
+        out += '\t';
+        out += meanings[i];
+        out += '\n';
+    }
+}
+
+// A RadixTrie has no batched lookup, so its words are looked up one at a time.
+static void answerExact(const RadixTrie *trie, const std::vector<std::string_view> &queries, std::string &out)
+{
+    std::string word;
+    for (std::string_view query : queries)
+    {
+        word.assign(query.data(), query.size());
+        out += query;
+        out += '\t';
+        out += getMeaning(trie, word);
+        out += '\n';
+    }
+}
+
+// Writes the query, a tab and the completions separated by spaces.
+static void appendCompletions(const std::string &query, const std::vector<std::string> &completions, std::string &out)
+{
+    out += query;
+    out += '\t';
+    for (size_t i = 0; i < completions.size(); i++)
+    {
+        if (i > 0)
+            out += ' ';
+        out += completions[i];
+    }
+    out += '\n';
+}
+
+// Prefix queries reuse the cursor's path, so sorted input only walks the letters that changed.
+static void answerPrefix(PrefixCursor &cursor, const Trie *trie, const std::string &query, size_t limit, std::string &out)
+{
+    cursorSeek(cursor, trie, query);
+    appendCompletions(query, getCompletions(cursor, limit), out);
+}
+
+static void answerPrefix(PrefixCursor &, const RadixTrie *trie, const std::string &query, size_t limit, std::string &out)
+{
+    appendCompletions(query, getCompletions(trie, query, limit), out);
+}
+
+static void answerFuzzy(const Trie *trie, const std::string &query, int distance, size_t limit, std::string &out)
+{
+    out += query;
+    out += '\t';
+    std::vector<FuzzyMatch> matches = getFuzzyMatches(trie, query, distance, limit);
+    for (size_t i = 0; i < matches.size(); i++)
+    {
+        if (i > 0)
+            out += ' ';
+        out += matches[i].word;
+        out += ':';
+        out += std::to_string(matches[i].distance);
+    }
+    out += '\n';
+}
+
+// Answers every line of the batch. Blank lines are skipped and a trailing '\r' is dropped.
+// Fuzzy queries need a Trie; parseOptions() turns them down for the other kinds.
+template <typename Dictionary>
+static void answerBatch(const Dictionary *trie, const Options &options, PrefixCursor &cursor, std::vector<std::string_view> &lines,
+                        std::string &query, Batch &batch)
+{
+    lines.clear();
+    std::string_view rest = batch.input;
+    while (!rest.empty())
+    {
+        size_t end = rest.find('\n');
+        std::string_view line = rest.substr(0, end);
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (!line.empty())
+            lines.push_back(line);
+    }
+
+    batch.output.reserve(batch.input.size() * (options.mode == MODE_EXACT ? 8 : 4));
+    if (options.mode == MODE_EXACT)
+        answerExact(trie, lines, batch.output);
+    for (size_t i = 0; options.mode != MODE_EXACT && i < lines.size(); i++)
+    {
+        query.assign(lines[i].data(), lines[i].size());
+        if (options.mode == MODE_PREFIX)
+            answerPrefix(cursor, trie, query, options.limit, batch.output);
+        else if constexpr (std::is_same<Dictionary, Trie>::value)
+            answerFuzzy(trie, query, options.distance, options.limit, batch.output);
+    }
+    batch.queries = lines.size();
+    batch.input = std::string();
+}
+
+template <typename Dictionary>
+static void queryThread(const Dictionary *trie, const Options &options, Pipeline &pipeline)
+{
+    PrefixCursor cursor;
+    std::vector<std::string_view> lines;
+    std::string query;
+    while (true)
+    {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            pipeline.changed.wait(lock, [&] { return !pipeline.pending.empty() || pipeline.inputDone; });
+            if (pipeline.pending.empty())
+                return;
+            batch = std::move(pipeline.pending.front());
+            pipeline.pending.pop_front();
+        }
+        answerBatch(trie, options, cursor, lines, query, batch);
+        {
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            size_t sequence = batch.sequence;
+            pipeline.finished.emplace(sequence, std::move(batch));
+        }
+        pipeline.changed.notify_all();
+    }
+}
+
+// Writes the answered batches in input order until `batchCount` have been written. Returns the
+// number of queries answered, or stops early if stdout cannot be written.
+static size_t writeOutput(Pipeline &pipeline, const size_t &batchCount, bool &writeFailed)
+{
+    size_t next = 0, queries = 0;
+    while (true)
+    {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            pipeline.changed.wait(lock, [&] {
+                return pipeline.finished.count(next) != 0 || (pipeline.inputDone && next == batchCount);
+            });
+            if (pipeline.finished.count(next) == 0)
+                return queries;
+            auto it = pipeline.finished.find(next);
+            batch = std::move(it->second);
+            pipeline.finished.erase(it);
+        }
+        if (!writeFailed && fwrite(batch.output.data(), 1, batch.output.size(), stdout) != batch.output.size())
+            writeFailed = true;
+        queries += batch.queries;
+        next++;
+        {
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            pipeline.inFlight--;
+        }
+        pipeline.changed.notify_all();
+    }
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--mode" && hasValue)
+        {
+            std::string mode = argv[++i];
+            if (mode == "exact")
+                options.mode = MODE_EXACT;
+            else if (mode == "prefix")
+                options.mode = MODE_PREFIX;
+            else if (mode == "fuzzy")
+                options.mode = MODE_FUZZY;
+            else
+                return false;
+        }
+        else if (arg == "--trie" && hasValue)
+        {
+            std::string kind = argv[++i];
+            if (kind == "standard")
+                options.trie = TRIE_STANDARD;
+            else if (kind == "radix")
+                options.trie = TRIE_RADIX;
+            else
+                return false;
+        }
+        else if (arg == "--limit" && hasValue)
+            options.limit = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--distance" && hasValue)
+            options.distance = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            options.threads = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--image" && hasValue)
+            options.image = argv[++i];
+        else if (arg == "--words" && hasValue)
+            options.words = argv[++i];
+        else if (arg == "--meanings" && hasValue)
+            options.meanings = argv[++i];
+        else if (arg == "--stats")
+            options.stats = true;
+        else if (!arg.empty() && arg[0] != '-' && options.input.empty())
+            options.input = arg;
+        else
+            return false;
+    }
+    return options.limit > 0 && options.distance >= 0 && !(options.mode == MODE_FUZZY && options.trie != TRIE_STANDARD);
+}
+
+// Runs the query threads and the writer over the whole input. Returns the number of queries answered.
+template <typename Dictionary>
+static size_t answerInput(const Dictionary *dictionary, const Options &options, int input, unsigned threadCount,
+                          bool &readFailed, bool &writeFailed)
+{
+    Pipeline pipeline;
+    pipeline.maxInFlight = size_t(threadCount) * 4;
+    size_t batchCount = 0, queries = 0;
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threadCount; i++)
+        threads.emplace_back(queryThread<Dictionary>, dictionary, std::cref(options), std::ref(pipeline));
+    std::thread writer([&] { queries = writeOutput(pipeline, batchCount, writeFailed); });
+
+    // Reads blocks and cuts them after their last newline; the partial line is carried into the next batch.
+    std::string carry;
+    std::vector<char> block(BATCH_BYTES);
+    while (true)
+    {
+        ssize_t got = ::read(input, block.data(), block.size());
+        if (got < 0)
+        {
+            readFailed = true;
+            break;
+        }
+        if (got == 0)
+            break;
+        carry.append(block.data(), size_t(got));
+        size_t cut = carry.rfind('\n');
+        if (carry.size() < BATCH_BYTES || cut == std::string::npos)
+            continue;
+
+        Batch batch;
+        batch.input.assign(carry, 0, cut + 1);
+        carry.erase(0, cut + 1);
+        std::unique_lock<std::mutex> lock(pipeline.mutex);
+        pipeline.changed.wait(lock, [&] { return pipeline.inFlight < pipeline.maxInFlight; });
+        batch.sequence = batchCount++;
+        pipeline.pending.push_back(std::move(batch));
+        pipeline.inFlight++;
+        lock.unlock();
+        pipeline.changed.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        if (!carry.empty())
+        {
+            Batch batch;
+            batch.sequence = batchCount++;
+            batch.input = std::move(carry);
+            pipeline.pending.push_back(std::move(batch));
+            pipeline.inFlight++;
+        }
+        pipeline.inputDone = true;
+    }
+    pipeline.changed.notify_all();
+
+    for (std::thread &thread : threads)
+        thread.join();
+    writer.join();
+    if (fflush(stdout) != 0)
+        writeFailed = true;
+    return queries;
+}
+
+/**
+ * @brief Answers dictionary queries in bulk, one per input line, without the UI.
+ *
+ * Usage: DictionaryQuery [--mode exact|prefix|fuzzy] [--trie standard|radix] [--limit N] [--distance N] [--threads N]
+ *                        [--image file] [--words file] [--meanings file] [--stats] [query file]
+ *
+ * Queries are read from the file, or from stdin when there is none. Each answer is one line on
+ * stdout, in input order: the query, a tab, then the meaning (exact; empty when the word is
+ * missing), up to --limit completions (prefix) or up to --limit matches within --distance edits
+ * as word:distance (fuzzy), separated by spaces. The dictionary is mapped from the image when it
+ * is up to date and loaded from the text files otherwise. --trie radix answers from a
+ * path-compressed RadixTrie loaded from the text files instead, for exact and prefix queries.
+ * --stats prints the throughput to stderr.
+ *
+ * @return int Returns 0 on success, 1 on bad arguments, unreadable input or a failed write.
+ */
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--mode exact|prefix|fuzzy] [--trie standard|radix] [--limit N] [--distance N] [--threads N]"
+                  << " [--image file] [--words file] [--meanings file] [--stats] [query file]" << std::endl;
+        return 1;
+    }
+
+    int input = options.input.empty() ? STDIN_FILENO : ::open(options.input.c_str(), O_RDONLY);
+    if (input < 0)
+    {
+        std::cerr << "Error: Could not open " << options.input << "." << std::endl;
+        return 1;
+    }
+
+    auto loadStart = std::chrono::steady_clock::now();
+    Trie *dictionary = nullptr;
+    RadixTrie *radix = nullptr;
+    if (options.trie == TRIE_RADIX)
+    {
+        radix = createRadixTrie();
+        if (!loadTextDictionary(radix, options.words, options.meanings))
+        {
+            std::cerr << "Error: Could not open dictionary files." << std::endl;
+            deleteTrie(radix);
+            return 1;
+        }
+    }
+    else
+        dictionary = openDictionaryImage(options.image, options.words, options.meanings);
+    if (dictionary == nullptr && radix == nullptr)
+    {
+        dictionary = createTrie();
+        if (!loadTextDictionaryParallel(dictionary, options.words, options.meanings))
+        {
+            std::cerr << "Error: Could not open dictionary files." << std::endl;
+            deleteTrie(dictionary);
+            return 1;
+        }
+    }
+    auto queryStart = std::chrono::steady_clock::now();
+
+    unsigned threadCount = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    static char outputBuffer[1 << 16];
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+    bool writeFailed = false, readFailed = false;
+    size_t queries = 0;
+    if (radix != nullptr)
+        queries = answerInput(radix, options, input, threadCount, readFailed, writeFailed);
+    else
+        queries = answerInput(dictionary, options, input, threadCount, readFailed, writeFailed);
+    auto end = std::chrono::steady_clock::now();
+    if (input != STDIN_FILENO)
+        ::close(input);
+
+    if (options.stats)
+    {
+        double seconds = std::chrono::duration<double>(end - queryStart).count();
+        size_t words = radix != nullptr ? countWords(radix, "") : countWords(dictionary, "");
+        std::cerr << "Loaded " << words << " words in "
+                  << std::chrono::duration<double, std::milli>(queryStart - loadStart).count() << " ms; answered " << queries
+                  << " queries in " << seconds * 1000 << " ms on " << threadCount << " threads ("
+                  << size_t(seconds > 0 ? double(queries) / seconds : 0) << " queries/s)" << std::endl;
+    }
+    deleteTrie(dictionary);
+    deleteTrie(radix);
+
+    if (readFailed)
+        std::cerr << "Error: Could not read the queries." << std::endl;
+    if (writeFailed)
+        std::cerr << "Error: Could not write the results." << std::endl;
+    return readFailed || writeFailed ? 1 : 0;
+}